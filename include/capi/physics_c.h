@@ -0,0 +1,71 @@
+/* physics_c.h */
+
+/* ---
+ * C ABI over VecEnv ( core/VecEnv.hpp ) for driving vectorised environments from other runtimes
+ * ( Python through ctypes/cffi, C#, Julia ... ) without copying state through per-body calls.
+
+ * Buffers:
+ * - Observations are float[worlds][max_bodies][PHYS_OBSERVATION_FIELDS]: x, y, rotation, vx, vy, angular velocity,
+ *   alive. Slots are bound to bodies on reset, a slot whose body was destroyed or culled reads all zeros.
+ * - Actions are float[worlds][max_bodies][PHYS_ACTION_FIELDS]: impulse x, impulse y, angular impulse.
+ * - phys_vecenv_observations() exposes the env's own observation buffer, so a runtime can wrap it once
+ *   ( e.g. numpy.ctypeslib.as_array ) and read every step's results in place.
+
+ * Ownership & Lifetime:
+ * - phys_vecenv_create() returns an env owned by the caller, released with phys_vecenv_destroy().
+ * - The pointer from phys_vecenv_observations() stays valid until the env is destroyed.
+ * - Buffers passed in are only read or written during the call.
+
+ * Thread Safety:
+ * - An env may be used from one thread at a time. Separate envs are independent.
+
+ * Error Handling:
+ * - phys_vecenv_create() returns NULL on failure and, if error is non-NULL, writes a message into it.
+ * - reset, step and observe return 0, or -1 if they failed ( out of memory, threads unavailable ), after which
+ *   the env's worlds and observations are unspecified until the next successful reset.
+ * - No C++ exception ever crosses this interface.
+ * --- */
+
+#ifndef PHYSICS_C_H
+#define PHYSICS_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PHYS_OBSERVATION_FIELDS 7
+#define PHYS_ACTION_FIELDS 3
+
+typedef struct PhysVecEnv PhysVecEnv;
+
+typedef struct PhysVecEnvDesc{
+    const char* scene_path; /* Text or binary scene ( io/Scene.hpp ), loaded once and copied into a world on reset */
+    uint32_t worlds;
+    uint32_t threads; /* 0 uses every hardware thread */
+    uint32_t max_bodies; /* Body slots per world in the buffers */
+    float dt; /* > 0, NaN is rejected */
+    int32_t substeps; /* World steps per phys_vecenv_step() */
+} PhysVecEnvDesc;
+
+PhysVecEnv* phys_vecenv_create(const PhysVecEnvDesc* desc, char* error, size_t error_size);
+void phys_vecenv_destroy(PhysVecEnv* env);
+
+size_t phys_vecenv_observation_size(const PhysVecEnv* env); /* In floats */
+size_t phys_vecenv_action_size(const PhysVecEnv* env);
+float* phys_vecenv_observations(PhysVecEnv* env);
+
+int phys_vecenv_reset(PhysVecEnv* env); /* Every world, observations written to the env's buffer */
+int phys_vecenv_reset_worlds(PhysVecEnv* env, const uint32_t* worlds, size_t count);
+
+/* actions may be NULL ( no impulses ), observations NULL writes the env's own buffer */
+int phys_vecenv_step(PhysVecEnv* env, const float* actions, float* observations);
+int phys_vecenv_observe(PhysVecEnv* env, float* observations);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PHYSICS_C_H */
@@ -22,7 +22,7 @@ struct AABB{
 };
 
 // Computes an AABB around a body's cached world-space vertices.
-AABB getAABB(const RigidBody& Body){
+inline AABB getAABB(const RigidBody& Body){
 
     // -- 
     // Returns an AABB bounding box for a polygon
@@ -51,7 +51,7 @@ AABB getAABB(const RigidBody& Body){
 }
 
 // Returns true if two AABBs overlap (including touching edges)
-bool AABBintersection(const AABB& a, const AABB& b) {
+inline bool AABBintersection(const AABB& a, const AABB& b) {
 
     // Separating axis tests for axis-aligned boxes.
     if (a.max.x < b.min.x || b.max.x < a.min.x) return false;
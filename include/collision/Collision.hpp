@@ -12,7 +12,7 @@
 
 //  Conventions:
 // - The normal is guaranteed to point from A -> B and is unit length
-// - penetration is the overlap depth along normal (>= 0 when colliding).
+// - penetration is the overlap depth along normal (>= 0 when colliding, < 0 for speculative contacts).
 // - 0 <= contactCount <= 2 
 // -----
 
@@ -28,11 +28,46 @@ struct Manifold{
     Vec2 contact1{0.0f,0.0f};
     Vec2 contact2{0.0f,0.0f};
     int contactCount{0};
-    float penetration{0.0f};
+    Real penetration{0.0f};
     bool inCollision{false};
 };
 
+// Contact between two convex polygons, see collidePolygons().
+struct PolygonContact{
+    Vec2 normal{0.0f,0.0f}; // From A to B
+    Vec2 contact1{0.0f,0.0f};
+    Vec2 contact2{0.0f,0.0f};
+    int contactCount{0};
+    Real penetration{0.0f}; // < 0 for speculative contacts
+};
+
+// SAT test between two convex polygons ( world-space vertices ), the building block of SATCollision and of
+// compound bodies' child pairs. centreA/centreB are interior points used to orient the normal A -> B.
+// Returns false when separated by more than speculativeMargin.
+bool collidePolygons(VertexSpan A,const Vec2& centreA,VertexSpan B,const Vec2& centreB,Real speculativeMargin,PolygonContact& out);
+
 // Narrow-phase SAT collision test between two rigid bodies.
 // Returns a Manifold containing contact data when colliding.
-Manifold SATCollision(RigidBody& RigidBodyA,RigidBody& RigidBodyB);  
+// With speculativeMargin > 0, bodies separated by at most the margin also return inCollision with a
+// negative penetration ( minus the gap ) and the closest points as contacts.
+Manifold SATCollision(RigidBody& RigidBodyA,RigidBody& RigidBodyB,Real speculativeMargin=0.0f);  
+
+// Boolean SAT overlap of two convex polygons ( world-space vertices ), stopping at the first separating axis.
+// Touching counts as overlapping. Cheaper than SATCollision as no depth, normal or contacts are produced.
+bool polygonsOverlap(VertexSpan A,VertexSpan B);
+
+// Exact segment test against a convex polygon ( world-space vertices, either winding ).
+// The segment is origin + t*delta for t in [0, maxFraction]. On a hit returns true with the entry
+// fraction and the outward unit normal of the entered edge. Segments starting inside the polygon do not hit.
+bool rayPolygon(const Vec2& origin,const Vec2& delta,VertexSpan vertices,Real maxFraction,Real& fraction,Vec2& normal);
+
+
+// True if p lies inside or on the boundary of a convex polygon ( world-space vertices, either winding ).
+bool pointInPolygon(const Vec2& p,VertexSpan vertices);
 
+// Time of impact of convex polygon A ( world-space vertices ) translating by delta against a fixed convex polygon B.
+// Exact for pure translation: SAT over both polygons' edge normals, taking the latest entry and earliest exit.
+// On a hit within [0, maxFraction] returns true with the fraction, the unit normal of the contact pointing from
+// B towards A, and the touching point. Polygons already overlapping hit at fraction 0 with a zero normal.
+bool sweepPolygons(VertexSpan A,const Vec2& delta,VertexSpan B,Real maxFraction,
+                   Real& fraction,Vec2& normal,Vec2& point);
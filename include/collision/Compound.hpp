@@ -0,0 +1,174 @@
+// Compound.hpp
+
+// ---
+// Compound bodies: one RigidBody made of several convex pieces, so concave props need neither extra bodies
+// nor joints. The pieces share the body's transform, mass and velocity.
+
+// Layout ( see RigidBody ):
+// - vertices / transformedVertices hold every piece back to back, children[i] gives piece i's run.
+// - childTree is a small BVH over the pieces in local space. The broad-phase only ever sees the whole-body
+//   AABB, the pieces are visited through the tree once that AABB overlaps something.
+
+// Authoring:
+// - decomposeConvex() splits a concave outline into convex pieces ( ear clipping, then Hertel-Mehlhorn
+//   merging of triangles back into the fewest convex polygons it can find ) ready for BodyDef::pieceCounts.
+// - composeShapes() assembles separately authored convex shapes ( BodyDef::shapes, each with its own
+//   offset, rotation and relative density ) into the same layout, aggregating their mass properties.
+
+// Mid-phase:
+// - Each child caches its world-space box whenever transformedVertices are rebuilt. forEachChildPair()
+//   walks one child tree per piece of the other body and only hands out pairs whose boxes overlap.
+
+// Contracts:
+// - forEachPiece()/forEachPieceNear() read transformedVertices, which must be current ( physEng::worldSpace ).
+// - A body without children is visited as a single piece, so callers need no special case.
+
+// Error Handling:
+// - decomposeConvex() returns false, leaving its outputs untouched, for outlines it cannot split
+//   ( fewer than 3 distinct points, zero area or self intersecting ).
+// ---
+
+#pragma once
+#include "core/RigidBody.hpp"
+#include "core/Vector2.hpp"
+#include "collision/AABB.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Splits a simple polygon ( either winding ) into convex CCW pieces, appended back to back to vertices with
+// their sizes appended to pieceCounts. The pieces are recentred on the outline's centre of mass, which is
+// written to centre if given ( place the body there to keep the shape where it was drawn ).
+bool decomposeConvex(const Vec2* outline, size_t count, std::vector<Vec2>& vertices, std::vector<uint32_t>& pieceCounts,
+                     Vec2* centre=nullptr);
+
+// Aggregated mass properties of a multi-shape body, see composeShapes().
+struct ComposedMass{
+    Vec2 centre{0.0f,0.0f}; // Centre of mass in the body frame the shapes were placed in
+    Real area{0.0f};
+    Real unitInertia{0.0f}; // About the centre of mass, for the mean density ( see setMassProperties )
+    Real weightedArea{0.0f}; // Sum of relative density * area, the total mass at BodyDef::density 1
+};
+
+// Places each shape in the body frame, then writes every piece back to back to vertices ( centred on the
+// combined centre of mass ) with its size in pieceCounts. Mass properties are summed over the shapes about
+// that centre, which is the parallel axis theorem applied piece by piece.
+// Returns false ( outputs untouched ) if any shape has fewer than 3 vertices or the total weight is zero.
+bool composeShapes(const ShapeDef* shapes, size_t count, std::vector<Vec2>& vertices, std::vector<uint32_t>& pieceCounts,
+                   ComposedMass& mass);
+
+// Interior point of a convex piece ( vertex average ), used to orient contact normals.
+inline Vec2 pieceCentre(VertexSpan piece){
+    Vec2 sum(0.0f,0.0f);
+    for (const Vec2& v : piece) sum+=v;
+    return sum*(1.0f/static_cast<Real>(piece.size()));
+}
+
+inline AABB pieceAABB(VertexSpan piece){
+    AABB box{piece[0],piece[0]};
+    for (const Vec2& v : piece){
+        box.min=Vec2(std::min(box.min.x,v.x),std::min(box.min.y,v.y));
+        box.max=Vec2(std::max(box.max.x,v.x),std::max(box.max.y,v.y));
+    }
+    return box;
+}
+
+// Bounds of a world-space box in the body's local frame.
+inline AABB toLocalBox(const RigidBody& body, const AABB& box){
+    const Real c=std::cos(body.rotation);
+    const Real s=std::sin(body.rotation);
+    const Real inf=std::numeric_limits<Real>::infinity();
+    AABB local{Vec2(inf,inf),Vec2(-inf,-inf)};
+    const Vec2 corners[4]={box.min,Vec2(box.max.x,box.min.y),box.max,Vec2(box.min.x,box.max.y)};
+    for (const Vec2& corner : corners){
+        const Vec2 d=corner-body.position;
+        const Vec2 p(d.x*c+d.y*s,-d.x*s+d.y*c); // Inverse rotation
+        local.min=Vec2(std::min(local.min.x,p.x),std::min(local.min.y,p.y));
+        local.max=Vec2(std::max(local.max.x,p.x),std::max(local.max.y,p.y));
+    }
+    return local;
+}
+
+// Calls fn(piece) with each world-space piece of body, stopping early when fn returns false.
+// Returns false if it was stopped.
+template <typename Fn>
+bool forEachPiece(const RigidBody& body, Fn&& fn){
+    const Vec2* v=body.transformedVertices.data();
+    if (!body.isCompound()) return fn(VertexSpan(v,body.transformedVertices.size()));
+    for (const ChildShape& child : body.children){
+        if (!fn(VertexSpan(v+child.first,child.count))) return false;
+    }
+    return true;
+}
+
+inline AABB childAABB(const ChildShape& child){ return AABB{child.min,child.max}; }
+
+// Calls fn(child) for every child of a compound body whose cached world box overlaps box, walking the child
+// tree with box taken into local space. Stops early when fn returns false, returns false if it was stopped.
+template <typename Fn>
+bool walkChildren(const RigidBody& body, const AABB& box, Fn&& fn){
+
+    if (body.childTree.empty()) return true;
+
+    const AABB local=toLocalBox(body,box);
+    constexpr int kStackSize=64;
+    uint32_t stack[kStackSize];
+    int top=0;
+    stack[top++]=0;
+
+    while (top>0){
+        const uint32_t index=stack[--top];
+        const ChildNode& node=body.childTree[index];
+        if (node.max.x<local.min.x || local.max.x<node.min.x || node.max.y<local.min.y || local.max.y<node.min.y) continue;
+
+        if (node.count>0){
+            const ChildShape& child=body.children[node.index];
+            if (AABBintersection(childAABB(child),box) && !fn(child)) return false;
+        } else if (top+2<=kStackSize){
+            stack[top++]=node.index;
+            stack[top++]=index+1;
+        }
+    }
+    return true;
+
+}
+
+// As forEachPiece(), but only for pieces whose AABB overlaps the world-space box.
+template <typename Fn>
+bool forEachPieceNear(const RigidBody& body, const AABB& box, Fn&& fn){
+    const Vec2* v=body.transformedVertices.data();
+    if (!body.isCompound()) return fn(VertexSpan(v,body.transformedVertices.size()));
+    return walkChildren(body,box,[&](const ChildShape& child){ return fn(VertexSpan(v+child.first,child.count)); });
+}
+
+// Mid-phase for a pair of bodies whose whole-body AABBs ( boxA, boxB ) overlap and at least one of which is
+// compound. Calls fn(pieceA, pieceB) for every child pair whose cached world boxes, grown by margin, overlap,
+// so SAT only runs on pieces that can actually touch. A single-polygon body takes part as one piece.
+template <typename Fn>
+void forEachChildPair(const RigidBody& A, const AABB& boxA, const RigidBody& B, const AABB& boxB, Real margin, Fn&& fn){
+
+    auto grow=[margin](AABB box){
+        box.min-=Vec2(margin,margin);
+        box.max+=Vec2(margin,margin);
+        return box;
+    };
+    const Vec2* va=A.transformedVertices.data();
+    const Vec2* vb=B.transformedVertices.data();
+    const VertexSpan wholeA(va,A.transformedVertices.size());
+    const VertexSpan wholeB(vb,B.transformedVertices.size());
+
+    if (!A.isCompound()){
+        walkChildren(B,grow(boxA),[&](const ChildShape& b){ fn(wholeA,VertexSpan(vb+b.first,b.count)); return true; });
+        return;
+    }
+    walkChildren(A,grow(boxB),[&](const ChildShape& a){
+        const VertexSpan pieceA(va+a.first,a.count);
+        if (!B.isCompound()) { fn(pieceA,wholeB); return true; }
+        walkChildren(B,grow(childAABB(a)),[&](const ChildShape& b){ fn(pieceA,VertexSpan(vb+b.first,b.count)); return true; });
+        return true;
+    });
+
+}
@@ -0,0 +1,80 @@
+// Edge.hpp
+
+// ---
+// One-sided edge segments for static terrain, created in bulk from chains ( polylines ) by World::createChain().
+
+// Conventions:
+// - Each edge is solid on its left going v1 -> v2, so a chain laid out left to right faces up, and a
+//   closed counter-clockwise loop faces outwards. Bodies whose centre is behind an edge pass through it.
+// - v0 and v3 are ghost vertices: the neighbouring chain points before v1 and after v2. They limit the
+//   contact normals an edge may produce, so a body sliding across a chain joint is never caught on the
+//   inner corner ( "internal edge snagging" ). Chain ends without a neighbour are free.
+
+// Ownership & Lifetime:
+// - EdgeShape is trivially copyable and owns nothing, so arrays of them are snapshotted verbatim.
+// - Edges belong to the World, and are only added or removed a chain at a time.
+// ---
+
+#pragma once
+#include "core/Vector2.hpp"
+#include "collision/AABB.hpp"
+#include "collision/Partitioning.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Stable reference to a chain of edges owned by a World. id 0 is never assigned.
+struct ChainHandle{
+    uint32_t id{0};
+    bool isValid() const { return id!=0; }
+    bool operator==(const ChainHandle& o) const { return id==o.id; }
+    bool operator!=(const ChainHandle& o) const { return id!=o.id; }
+};
+
+// Plain description of a chain. points is copied, count >= 2 ( >= 3 for loops ).
+struct ChainDef{
+    const Vec2* points{nullptr};
+    size_t count{0};
+    bool loop{false}; // Also joins the last point back to the first
+
+    Real staticFriction{0.2f};
+    Real dynamicFriction{0.8f};
+    Real restitution{0.0f};
+    uint16_t categoryBits{0x0001};
+    uint16_t maskBits{0xFFFF};
+    int16_t groupIndex{0};
+};
+
+struct EdgeShape{
+    Vec2 v0, v1, v2, v3; // Segment v1 -> v2 with ghost vertices v0 and v3
+    Vec2 normal; // Unit front normal, left of v1 -> v2
+    uint8_t hasV0{0};
+    uint8_t hasV3{0};
+    uint16_t pad{0};
+    uint32_t chain{0}; // ChainHandle id
+    Real staticFriction{0.2f};
+    Real dynamicFriction{0.8f};
+    Real restitution{0.0f};
+    partioning::CollisionFilter filter{};
+};
+
+// Contact between an edge and a convex polygon.
+struct EdgeContact{
+    Vec2 normal; // Unit, pointing from the edge to the polygon
+    Vec2 points[2];
+    int count{0};
+    Real penetration{0.0f}; // < 0 for a speculative contact
+};
+
+inline AABB getEdgeAABB(const EdgeShape& edge){
+    return AABB{
+        Vec2(std::min(edge.v1.x,edge.v2.x),std::min(edge.v1.y,edge.v2.y)),
+        Vec2(std::max(edge.v1.x,edge.v2.x),std::max(edge.v1.y,edge.v2.y))
+    };
+}
+
+// Collides a one-sided edge with a convex polygon ( world-space vertices, centre strictly inside ).
+// Polygons within margin of the edge still produce a speculative contact. Returns false when separated,
+// behind the edge, or when the only admissible contact is blocked by a ghost vertex.
+bool collideEdgePolygon(const EdgeShape& edge,VertexSpan polygon,const Vec2& centre,Real margin,EdgeContact& out);
@@ -1,19 +1,28 @@
 // Partitioning.hpp
 // This is a basic uniform-grid spatial hashing, used to find narrow-phase candidates.
 
+// The grid is stored flat: one (cell key, body index) entry per overlapped cell, sorted by key
+// and then by body index. Pair generation walks the sorted runs, so candidate pairs come out
+// in the same order on every platform and standard library ( required for deterministic replay ).
+// A pair overlapping several cells is only emitted from the first cell both bodies share,
+// which removes duplicates without a hash set.
+// Optional per-body CollisionFilters, kept in an array parallel to the AABBs, drop filtered and
+// static-static pairs while the cell runs are walked, before any AABB re-test or narrow-phase.
+// Pairs involving a sensor are dropped as well, sensors get their own overlap pass.
+
 #pragma once
 #include <vector>
-#include <unordered_map>
-#include <unordered_set>
 #include <utility>
 #include <cstdint>
 #include <cmath>
-#include "collision/AABB.hpp" 
+#include <algorithm>
+#include <limits>
+#include "collision/AABB.hpp"
 
 namespace partioning {
 
 struct GridConfig {
-    float cellSize = 3.0f; // Size of each grid cell 
+    Real cellSize = 3.0f; // Size of each grid cell
 };
 
 // Packs 2D cell coords into one 64-bit key
@@ -21,70 +30,162 @@ inline uint64_t cellKey(int cx, int cy) {
     return (uint64_t(uint32_t(cx)) << 32) | uint32_t(cy);
 }
 
+inline int cellKeyX(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key >> 32)); }
+inline int cellKeyY(uint64_t key) { return static_cast<int>(static_cast<uint32_t>(key)); }
+
 // Packs a pair of body indices into a unique 64-bit key
 inline uint64_t pairKey(int a, int b) {
     if (a > b) std::swap(a, b);
     return (uint64_t(uint32_t(a)) << 32) | uint32_t(b);
 }
 
-inline int cellCoord(float x, float cellSize) {
-    return static_cast<int>(std::floor(x / cellSize));
+// Cell coordinates are clamped to +-kMaxCellCoord, so far away ( or NaN ) positions never overflow the cast
+// and range widths ( or the sum of two, as in a ray walk ) always fit an int.
+constexpr int kMaxCellCoord = 1 << 28;
+
+inline int cellCoord(Real x, Real cellSize) {
+    Real c = std::floor(x / cellSize);
+    if (!(c > Real(-kMaxCellCoord))) c = Real(-kMaxCellCoord); // Also catches NaN
+    if (c > Real(kMaxCellCoord)) c = Real(kMaxCellCoord);
+    return static_cast<int>(c);
+}
+
+struct CellEntry {
+    uint64_t key;
+    int body;
+    bool operator<(const CellEntry& o) const { return key < o.key || (key == o.key && body < o.body); }
+};
+
+// Compact copy of a body's filter data ( 8 bytes ), built alongside its AABB.
+struct CollisionFilter {
+    uint16_t category = 0x0001;
+    uint16_t mask = 0xFFFF;
+    int16_t group = 0;
+    uint8_t isStatic = 0;
+    uint8_t isSensor = 0;
+};
+
+// Same group: positive always collides, negative never. Otherwise category/mask must match both ways.
+// Two static bodies never collide.
+inline bool shouldCollide(const CollisionFilter& a, const CollisionFilter& b) {
+    if (a.isStatic && b.isStatic) return false;
+    if (a.group != 0 && a.group == b.group) return a.group > 0;
+    return (a.mask & b.category) != 0 && (b.mask & a.category) != 0;
 }
 
-inline std::vector<std::pair<int,int>> buildPairsFromAABBs(const std::vector<AABB>& aabbs, const GridConfig& cfg) {
+struct CellRange { // Inclusive range of cells overlapped by one AABB
+    int x0, y0, x1, y1;
+};
+
+class SpatialGrid {
+
+    public:
+
+    GridConfig config;
+
+    // Rebuilds the grid over aabbs ( index i in aabbs is body i ). Storage is reused between builds.
+    void build(const std::vector<AABB>& aabbs) {
 
-    // Build candidate pairs from AABBs using a spatial hash grid.
-    // Returns pairs of indices (i,j) into bodies/AABB arrays.
+        m_ranges.resize(aabbs.size());
+        m_entries.clear();
+        m_bounds = AABB{Vec2(0.0f, 0.0f), Vec2(0.0f, 0.0f)};
+        if (!aabbs.empty()) m_bounds = aabbs[0];
 
-    std::unordered_map<uint64_t, std::vector<int>> buckets;
-    buckets.reserve(aabbs.size() * 2);
+        // Insert indices into cells
+        for (int i = 0; i < (int)aabbs.size(); ++i) {
+            const AABB& b = aabbs[i];
 
-    // Insert indices into buckets
-    for (int i = 0; i < (int)aabbs.size(); ++i) {
-        const AABB& b = aabbs[i];
+            // Compute grid-cell range overlapped by this AABB
+            CellRange r{
+                cellCoord(b.min.x, config.cellSize), cellCoord(b.min.y, config.cellSize),
+                cellCoord(b.max.x, config.cellSize), cellCoord(b.max.y, config.cellSize)
+            };
+            m_ranges[i] = r;
 
-        // Compute grid-cell range overlapped by this AABB
-        int x0 = cellCoord(b.min.x, cfg.cellSize);
-        int x1 = cellCoord(b.max.x, cfg.cellSize);
-        int y0 = cellCoord(b.min.y, cfg.cellSize);
-        int y1 = cellCoord(b.max.y, cfg.cellSize);
+            m_bounds.min.x = std::min(m_bounds.min.x, b.min.x);
+            m_bounds.min.y = std::min(m_bounds.min.y, b.min.y);
+            m_bounds.max.x = std::max(m_bounds.max.x, b.max.x);
+            m_bounds.max.y = std::max(m_bounds.max.y, b.max.y);
 
-        for (int cy = y0; cy <= y1; ++cy) {
-            for (int cx = x0; cx <= x1; ++cx) {
-                buckets[cellKey(cx, cy)].push_back(i);
+            for (int cy = r.y0; cy <= r.y1; ++cy) {
+                for (int cx = r.x0; cx <= r.x1; ++cx) {
+                    m_entries.push_back({cellKey(cx, cy), i});
+                }
             }
         }
+
+        std::sort(m_entries.begin(), m_entries.end());
+
     }
 
-    // Generate unique pairs within each bucket
-    std::unordered_set<uint64_t> seen;
-    seen.reserve(aabbs.size() * 8);
+    const std::vector<CellEntry>& entries() const { return m_entries; }
+    const CellRange& range(int body) const { return m_ranges[body]; }
+    const AABB& bounds() const { return m_bounds; } // Union of every AABB in the last build
+    size_t bodyCount() const { return m_ranges.size(); }
+
+    // Returns the [first, last) entries stored in cell (cx, cy), empty if the cell is unoccupied.
+    // Read-only, so it may be called from several threads at once.
+    std::pair<const CellEntry*, const CellEntry*> cell(int cx, int cy) const {
+        uint64_t key = cellKey(cx, cy);
+        auto first = std::lower_bound(m_entries.begin(), m_entries.end(), CellEntry{key, std::numeric_limits<int>::min()});
+        auto last = first;
+        while (last != m_entries.end() && last->key == key) ++last;
+        const CellEntry* base = m_entries.data();
+        return {base + (first - m_entries.begin()), base + (last - m_entries.begin())};
+    }
+
+    private:
+
+    std::vector<CellEntry> m_entries; // Sorted by (key, body)
+    std::vector<CellRange> m_ranges; // Per body
+    AABB m_bounds{};
+
+};
+
+inline void buildPairsFromAABBs(const std::vector<AABB>& aabbs, SpatialGrid& grid, std::vector<std::pair<int,int>>& pairs,
+                                const std::vector<CollisionFilter>* filters = nullptr) {
+
+    // Build candidate pairs from AABBs using the spatial hash grid.
+    // Writes pairs of indices (i,j), i < j, into bodies/AABB arrays, in a deterministic order.
+    // filters, if given, is parallel to aabbs and rejects pairs that shouldCollide() refuses.
+
+    grid.build(aabbs);
+    pairs.clear();
 
-    std::vector<std::pair<int,int>> pairs;
-    pairs.reserve(aabbs.size() * 4);
+    const auto& entries = grid.entries();
+    size_t runStart = 0;
 
-    for (auto& [key, ids] : buckets) {  // Iterate over each occupied grid cell
-       
-        if (ids.size() < 2) continue;
+    while (runStart < entries.size()) {  // Iterate over each occupied grid cell
 
-        for (size_t a = 0; a < ids.size(); ++a) { // Generate all unique pairs within this cell
-            for (size_t b = a + 1; b < ids.size(); ++b) {
-                int i = ids[a];
-                int j = ids[b];
+        uint64_t key = entries[runStart].key;
+        size_t runEnd = runStart + 1;
+        while (runEnd < entries.size() && entries[runEnd].key == key) ++runEnd;
 
-                // Create unique order-independent pair key
-                uint64_t pk = pairKey(i, j);
-                if (seen.insert(pk).second) {
-                    // Only emit pair once across all cells
-                    pairs.push_back({i, j});
+        int cx = cellKeyX(key);
+        int cy = cellKeyY(key);
+
+        for (size_t a = runStart; a < runEnd; ++a) { // Generate all unique pairs within this cell
+            for (size_t b = a + 1; b < runEnd; ++b) {
+                int i = entries[a].body;
+                int j = entries[b].body;
+
+                // Only emit the pair from the first cell the two ranges share
+                const CellRange& ri = grid.range(i);
+                const CellRange& rj = grid.range(j);
+                if (cx != std::max(ri.x0, rj.x0) || cy != std::max(ri.y0, rj.y0)) continue;
+                if (filters) {
+                    const CollisionFilter& fi = (*filters)[i];
+                    const CollisionFilter& fj = (*filters)[j];
+                    if (fi.isSensor || fj.isSensor || !shouldCollide(fi, fj)) continue;
                 }
-                
+
+                pairs.push_back({i, j});
             }
         }
 
+        runStart = runEnd;
     }
 
-    return pairs; // Returns canditate pairs for narrow testing 
 }
 
 } // namespace broadphase
@@ -0,0 +1,134 @@
+// StaticGeometry.hpp
+
+// ---
+// Baked static level geometry: the World's edges plus a bounding volume hierarchy over them.
+
+// The BVH is built with binned SAH ( surface area heuristic, perimeter in 2D ) and flattened depth first:
+// a node's left child directly follows it and the right child is stored by index. Nodes are 32 byte aligned:
+// 32 bytes with float Real, two per cache line, and 64 bytes with double. Edges are reordered so every leaf
+// references a contiguous run.
+
+// A bake can be written to disk with save() and loaded with load(), which maps the file and uses the
+// node and edge sections in place, so big levels load without building anything at runtime.
+
+// Baked file layout ( native endianness, sections 32 byte aligned at the offsets in the header ):
+//   [BakeHeader][BVHNode x nodeCount][EdgeShape x edgeCount]
+
+// Ownership & Lifetime:
+// - StaticGeometry owns its edges and nodes, either in memory or through a MappedFile.
+// - Pointers from edges()/nodes() are invalidated by build(), load() and destruction.
+// - Move-only, as a mapped bake cannot be copied cheaply. assign() makes an explicit copy.
+// - Worlds hold it through shared_ptr<const StaticGeometry>, so one bake can back many Worlds.
+
+// Thread Safety:
+// - query() is read-only and may run on several threads at once, including from Worlds sharing the bake.
+
+// Error Handling:
+// - load() returns false for missing, foreign or truncated files and leaves the geometry unchanged.
+// ---
+
+#pragma once
+#include "collision/AABB.hpp"
+#include "collision/Edge.hpp"
+#include "io/MappedFile.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct alignas(32) BVHNode{
+    AABB box;
+    uint32_t index; // Leaf: first edge. Interior: right child ( the left child is the next node )
+    uint32_t count; // Edges in a leaf, 0 for interior nodes
+};
+static_assert(sizeof(BVHNode)==(sizeof(Real)==sizeof(float) ? 32 : 64),"BVHNode size changed, update the layout notes");
+
+namespace bake {
+
+constexpr uint32_t kBakeMagic=0x48564253; // "SBVH"
+constexpr uint32_t kBakeVersion=1;
+
+struct BakeHeader{
+    uint32_t magic{kBakeMagic};
+    uint32_t version{kBakeVersion};
+    uint32_t nodeSize{sizeof(BVHNode)};
+    uint32_t edgeSize{sizeof(EdgeShape)};
+    uint64_t nodeCount{0};
+    uint64_t edgeCount{0};
+    uint64_t nodeOffset{0};
+    uint64_t edgeOffset{0};
+};
+
+} // namespace bake
+
+class StaticGeometry{
+
+    public:
+
+    StaticGeometry()=default;
+    StaticGeometry(StaticGeometry&&)=default;
+    StaticGeometry& operator=(StaticGeometry&&)=default;
+    StaticGeometry(const StaticGeometry&)=delete;
+    StaticGeometry& operator=(const StaticGeometry&)=delete;
+
+    void build(std::vector<EdgeShape>&& edges); // Takes the edges ( reordered ) and bakes the BVH
+    bool save(const std::string& path) const; // Writes the bake, returns success
+    bool load(const std::string& path); // Maps a bake written by save(), returns success
+    void assign(const StaticGeometry& other); // Copies another bake into owned memory, nothing is rebuilt
+    void translate(const Vec2& delta); // Moves every edge and node box, copying a mapped bake into memory first
+
+    const EdgeShape* edges() const { return m_edgeData; }
+    size_t edgeCount() const { return m_edgeCount; }
+    const BVHNode* nodes() const { return m_nodeData; }
+    size_t nodeCount() const { return m_nodeCount; }
+    bool empty() const { return m_edgeCount==0; }
+    bool isMapped() const { return m_file.isOpen(); }
+
+    // Calls fn(edgeIndex, edge) for every edge whose AABB overlaps box.
+    template <typename Fn> void query(const AABB& box, Fn&& fn) const;
+
+    private:
+
+    void buildNodes();
+    void usePointers(); // Points the accessors at the owned vectors
+
+    std::vector<EdgeShape> m_edges; // Owned storage, empty when mapped
+    std::vector<BVHNode> m_nodes;
+    MappedFile m_file; // Backing storage for a loaded bake
+
+    const EdgeShape* m_edgeData=nullptr;
+    size_t m_edgeCount=0;
+    const BVHNode* m_nodeData=nullptr;
+    size_t m_nodeCount=0;
+
+};
+
+template <typename Fn>
+void StaticGeometry::query(const AABB& box, Fn&& fn) const{
+
+    // Iterative depth-first walk with a fixed stack. The build caps SAH splits at depth 48 and
+    // falls back to median splits, so trees stay well inside the stack.
+
+    if (m_nodeCount==0) return;
+
+    constexpr int kStackSize=128;
+    uint32_t stack[kStackSize];
+    int top=0;
+    stack[top++]=0;
+
+    while (top>0){
+        const uint32_t nodeIndex=stack[--top];
+        const BVHNode& node=m_nodeData[nodeIndex];
+        if (!AABBintersection(node.box,box)) continue;
+
+        if (node.count>0){
+            for (uint32_t i=node.index;i<node.index+node.count;++i){
+                if (AABBintersection(getEdgeAABB(m_edgeData[i]),box)) fn(i,m_edgeData[i]);
+            }
+        } else if (top+2<=kStackSize){
+            stack[top++]=node.index;
+            stack[top++]=nodeIndex+1;
+        }
+    }
+
+}
@@ -0,0 +1,23 @@
+// Config.hpp
+
+// ---
+// Build-wide configuration of the simulation scalar.
+
+// Real is the scalar every simulation type is built on ( Vec2, RigidBody, the solver and the queries ).
+// It is float by default. Configure with -DPHYS_DOUBLE_PRECISION=ON for double, which keeps bodies far
+// from the origin ( km scale worlds ) precise at the cost of memory bandwidth and throughput
+// ( see PhysBench scalar for the numbers on a given machine ).
+
+// Contracts:
+// - Snapshots and binary scenes store Real verbatim and record its size, so files written by one
+//   precision are rejected by the other.
+// - Rendering, colours, authored materials and the recorder's quantization steps stay float.
+// ---
+
+#pragma once
+
+#ifdef PHYS_DOUBLE_PRECISION
+using Real=double;
+#else
+using Real=float;
+#endif
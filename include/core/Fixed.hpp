@@ -0,0 +1,85 @@
+// Fixed.hpp
+
+// ---
+// Q16.16 fixed-point scalar for lockstep simulation, where every peer must compute bit-identical results.
+
+// Every operation is integer arithmetic, so results never depend on the compiler, the FPU, FMA contraction
+// or the standard library. sin/cos come from a quarter-wave table and sqrt is an exact integer root, both
+// found by argument dependent lookup, so Vec2T<Fixed>, TransformT<Fixed> and the vecMath templates work as is.
+
+// Conventions:
+// - raw holds value * 65536. The range is about +-32768 with a resolution of 1.5e-5.
+// - Products and quotients round to nearest. Overflow wraps modulo 2^32: sums, differences and negation are
+//   done in uint32_t, so they are never signed overflow ( keep values in range all the same ).
+// - Conversions from float/double are exact up to rounding, so constants built from literals are portable.
+//   Converting back to float is only meant for rendering and reporting.
+
+// Thread Safety:
+// - The trig table is built on first use ( thread-safe static initialisation ) and is read-only afterwards.
+// ---
+
+#pragma once
+#include "core/Vector2.hpp"
+#include <cmath>
+#include <cstdint>
+
+namespace fixedpoint {
+
+struct Fixed{
+
+    int32_t raw{0};
+
+    static constexpr int kFractionBits=16;
+    static constexpr int32_t kOne=1<<kFractionBits;
+
+    constexpr Fixed()=default;
+    constexpr explicit Fixed(int value) : raw(wrap(static_cast<uint32_t>(value)<<kFractionBits)) {}
+    explicit Fixed(float value) : raw(static_cast<int32_t>(std::lround(static_cast<double>(value)*kOne))) {}
+    explicit Fixed(double value) : raw(static_cast<int32_t>(std::lround(value*kOne))) {}
+
+    static constexpr Fixed fromRaw(int32_t raw){ Fixed f; f.raw=raw; return f; }
+    static constexpr int32_t wrap(uint32_t bits){ return static_cast<int32_t>(bits); } // Two's complement, as every target is
+    float toFloat() const { return static_cast<float>(raw)/kOne; }
+    explicit operator float() const { return toFloat(); }
+
+    Fixed operator +(Fixed o) const { return fromRaw(wrap(static_cast<uint32_t>(raw)+static_cast<uint32_t>(o.raw))); }
+    Fixed operator -(Fixed o) const { return fromRaw(wrap(static_cast<uint32_t>(raw)-static_cast<uint32_t>(o.raw))); }
+    Fixed operator -() const { return fromRaw(wrap(0u-static_cast<uint32_t>(raw))); }
+    Fixed operator *(Fixed o) const {
+        return fromRaw(static_cast<int32_t>((static_cast<int64_t>(raw)*o.raw+(kOne/2))>>kFractionBits));
+    }
+    Fixed operator /(Fixed o) const {
+        if (o.raw==0) return fromRaw(raw>=0 ? INT32_MAX : INT32_MIN); // Saturate rather than trap
+        const int64_t n=static_cast<int64_t>(raw)*kOne;
+        const int64_t d=o.raw;
+        int64_t q=n/d;
+        const int64_t r=n%d;
+        if (2*(r<0 ? -r : r)>=(d<0 ? -d : d)) q+=((n<0)!=(d<0)) ? -1 : 1; // Round half away from zero
+        return fromRaw(static_cast<int32_t>(q));
+    }
+
+    Fixed& operator +=(Fixed o) { *this=*this+o; return *this; }
+    Fixed& operator -=(Fixed o) { *this=*this-o; return *this; }
+    Fixed& operator *=(Fixed o) { *this=*this*o; return *this; }
+    Fixed& operator /=(Fixed o) { *this=*this/o; return *this; }
+
+    bool operator ==(Fixed o) const { return raw==o.raw; }
+    bool operator !=(Fixed o) const { return raw!=o.raw; }
+    bool operator <(Fixed o) const { return raw<o.raw; }
+    bool operator <=(Fixed o) const { return raw<=o.raw; }
+    bool operator >(Fixed o) const { return raw>o.raw; }
+    bool operator >=(Fixed o) const { return raw>=o.raw; }
+
+};
+
+// Deterministic replacements for the <cmath> functions, picked up by argument dependent lookup.
+// Defined in fixed.cpp.
+Fixed sqrt(Fixed x); // Exact integer root, 0 for x <= 0
+Fixed sin(Fixed radians); // Quarter-wave table of 1024 steps with linear interpolation, error < 2e-5
+Fixed cos(Fixed radians);
+inline Fixed abs(Fixed x) { return x.raw<0 ? -x : x; }
+
+} // namespace fixedpoint
+
+using Fixed=fixedpoint::Fixed;
+using Vec2Fixed=Vec2T<fixedpoint::Fixed>;
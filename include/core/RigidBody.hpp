@@ -15,6 +15,9 @@
 //.  vertices in their actual location, rather than being relative to the COM )
 // - If update == true, this implies the body has moved, transformedVertices 
 //.  MUST be recached to reflect the body's new position and rotation.
+// - A compound body's vertices hold several convex pieces back to back, described by children
+//   ( see collision/Compound.hpp ). transformedVertices follow the same layout, so the whole-body
+//   AABB is still the box around every vertex. A body without children is a single convex polygon.
 
 // Thread Safety:
 // - RigidBody is NOT thread-safe.
@@ -25,6 +28,8 @@
 #pragma once
 #include "core/Vector2.hpp"
 #include <vector>
+#include <cstddef>
+#include <cstdint>
 
 enum ShapeType{ // Implement later for optimisation
     Circle,Rectangle,Polygon
@@ -33,39 +38,125 @@ struct Colour{
     float r,g,b;
 };
 
+// Stable reference to a body owned by a World. Unlike an index into getBodies(), a handle
+// survives other bodies being created, destroyed or culled. id 0 is never assigned.
+struct BodyHandle{
+    uint32_t id{0};
+    bool isValid() const { return id!=0; }
+    bool operator==(const BodyHandle& o) const { return id==o.id; }
+    bool operator!=(const BodyHandle& o) const { return id!=o.id; }
+};
+
+// One convex child shape of a multi-shape body ( e.g. a vehicle's chassis and wheels as one body ).
+// vertices are in the shape's own frame, offset/rotation place it in the body frame. The body's centre of
+// mass, mass and inertia are aggregated over every shape at creation ( parallel axis theorem ), and the
+// body is then positioned so the body frame origin sits at BodyDef::position.
+struct ShapeDef{
+    const Vec2* vertices{nullptr};
+    size_t vertexCount{0};
+    Vec2 offset{0.0f,0.0f};
+    Real rotation{0.0f};
+    Real density{1.0f}; // Relative to the other shapes, BodyDef::mass or density sets the total
+};
+
+// Plain description of a body, used to create bodies in bulk ( World::createBodies ).
+// vertices points at a local-space convex polygon centred on the COM, which is copied into
+// each body, so many defs can share one prototype array.
+// For a compound body, vertices holds pieceCount convex pieces back to back ( pieceCounts[i] vertices
+// each, centred on the combined COM ), as written by decomposeConvex().
+// Alternatively shapes lists separately authored convex shapes placed in the body frame, see ShapeDef.
+struct BodyDef{
+    const Vec2* vertices{nullptr};
+    size_t vertexCount{0};
+    const uint32_t* pieceCounts{nullptr}; // nullptr for a single convex polygon
+    size_t pieceCount{0};
+    const ShapeDef* shapes{nullptr}; // Takes priority over vertices when set
+    size_t shapeCount{0};
+    ShapeType shape{Polygon};
+
+    Vec2 position{0.0f,0.0f};
+    Real rotation{0.0f};
+    Vec2 linearVelocity{0.0f,0.0f};
+    Real angularVelocity{0.0f};
+
+    Real mass{0.0f}; // Takes priority when > 0
+    Real density{0.0f}; // Otherwise mass = density * area
+    Real staticFriction{0.2f};
+    Real dynamicFriction{0.8f};
+    Real restitution{0.0f};
+    bool isStatic{false};
+    bool isBullet{false}; // Continuous collision against other bodies, see RigidBody::isBullet
+    bool isSensor{false}; // Overlap events only, see RigidBody::isSensor
+    uint16_t categoryBits{0x0001}; // Collision filtering, see RigidBody::categoryBits
+    uint16_t maskBits{0xFFFF};
+    int16_t groupIndex{0};
+    Colour colour{255.0f,255.0f,255.0f};
+};
+
+// One convex piece of a compound body: vertices [first, first + count), with world-space bounds cached
+// alongside transformedVertices for the mid-phase.
+struct ChildShape{
+    uint32_t first;
+    uint32_t count;
+    Vec2 min{0.0f,0.0f};
+    Vec2 max{0.0f,0.0f};
+};
+
+// Node of a compound body's child BVH, in local space. Flattened depth first: a node's left child directly
+// follows it, the right child is stored by index.
+struct ChildNode{
+    Vec2 min;
+    Vec2 max;
+    uint32_t index; // Leaf: child shape. Interior: right child
+    uint32_t count; // 1 for leaves, 0 for interior nodes
+};
+
 struct RigidBody{ 
 
-    ShapeType shape; // Used to discern circle or rectangle for more efficent collision detection later on
-    int sides; // Sides 
-    int radius; // Radius 
+    ShapeType shape{Polygon}; // Used to discern circle or rectangle for more efficent collision detection later on
+    int sides{0}; // Sides 
+    int radius{0}; // Radius 
     // Constructor 
     RigidBody()=default;
-    RigidBody(int n, float radius,float mass);
+    RigidBody(int n, Real radius,Real mass);
+    RigidBody(const BodyDef& def, Real area, Real unitInertia); // Mass props precomputed, see computePolygonMassProperties
     ~RigidBody()=default;
 
     Vec2 force;
     Vec2 position{0.0f,0.0f};
-    float rotation{0.0f}; // Radians
+    Real rotation{0.0f}; // Radians
     Vec2 linearVelocity{0.0f,0.0f};
     Vec2 linearAcceleration{0.0f,0.0f};
-    float angularVelocity{0.0f};
-    float angularAcceleration{0.0f};
+    Real angularVelocity{0.0f};
+    Real angularAcceleration{0.0f};
     Colour colour{255.0f,255.0f,255.0f};
 
-    float inertia{0.0f};
-    float inverseInertia{0.0f};
-    float staticFriction{0.2f};
-    float dynamicFriction{0.8f};
-    float density{0.0f}; 
-    float mass{0.0f};
-    float inverseMass{0.0f};
-    float restitution{0.0f};
-    float area{0.0f};
+    Real inertia{0.0f};
+    Real inverseInertia{0.0f};
+    Real staticFriction{0.2f};
+    Real dynamicFriction{0.8f};
+    Real density{0.0f}; 
+    Real mass{0.0f};
+    Real inverseMass{0.0f};
+    Real restitution{0.0f};
+    Real area{0.0f};
     bool isStatic{false};
+    bool isBullet{false}; // Fast body: swept against the world each step so it cannot tunnel through thin bodies
+    bool isSensor{false}; // Trigger volume: never collides, only reports overlap begin/end ( World::getSensorEvents )
+
+    // Collision filtering, applied by the broad-phase before any narrow-phase work.
+    // Two bodies sharing a non-zero groupIndex always collide if it is positive and never if negative.
+    // Otherwise they collide only when each one's category is in the other's mask.
+    uint16_t categoryBits{0x0001};
+    uint16_t maskBits{0xFFFF};
+    int16_t groupIndex{0};
    
     std::vector<Vec2> vertices {}; // Vertices relative to the bodies COM
     std::vector<Vec2> transformedVertices {}; // Cached transformed vertices 
+    std::vector<ChildShape> children {}; // Convex pieces of a compound body, empty for a single polygon
+    std::vector<ChildNode> childTree {}; // Local-space BVH over children, built by setChildShapes()
     bool update{false}; // Whether the transformed vertices need to be recalculated 
+    uint32_t id{0}; // Assigned by the World, see BodyHandle
 
     // Position and rotation incrementing and setting 
 
@@ -74,7 +165,7 @@ struct RigidBody{
         update=true;
     }
     
-    void rotate(const float radians){ // Rotate rigid body by given radians 
+    void rotate(const Real radians){ // Rotate rigid body by given radians 
         rotation+=radians;
         update=true;
     }
@@ -84,8 +175,17 @@ struct RigidBody{
         update=true;
     }
 
+    bool isCompound() const { return !children.empty(); }
+
 };
 
 // Defined in RigidBody.cpp
-float calculateInertia(RigidBody& body);
-void setBoxVertices(RigidBody& body, float height, float width);
+Real calculateInertia(RigidBody& body);
+void setBoxVertices(RigidBody& body, Real height, Real width);
+std::vector<Vec2> generateRegularPolygon(int n, Real r);
+void computePolygonMassProperties(const Vec2* vertices, size_t count, Real& area, Real& unitInertia);
+void setMassProperties(RigidBody& body, Real mass, Real area, Real unitInertia);
+void setMassFromVertices(RigidBody& body, Real mass);
+void computePieceMassProperties(const Vec2* vertices, const uint32_t* pieceCounts, size_t pieceCount, Real& area, Real& unitInertia);
+void setChildShapes(RigidBody& body, const uint32_t* pieceCounts, size_t pieceCount); // Splits vertices into pieces, builds childTree
+void refreshChildBounds(RigidBody& body); // Recomputes each child's world-space bounds from transformedVertices
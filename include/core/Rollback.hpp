@@ -0,0 +1,70 @@
+// Rollback.hpp
+
+// ---
+// Ring of preallocated World states for rollback netcode: save every simulated frame, and when a late input
+// arrives restore the frame it belongs to and resimulate from there.
+
+// A frame holds only what a step changes: each body's pose and velocities ( BodyState ), the ids they belong
+// to, and the touching/sensor pairs the event system compares against. Shapes, mass, materials and statics
+// are not stored, so a frame restores onto the World that saved it, with the same bodies.
+
+// Ownership & Lifetime:
+// - All storage is allocated by the constructor: frames * maxBodies states and ids, frames * maxPairs pairs.
+//   save() and restore() never allocate ( restore() reuses the World's own buffers once they have grown ).
+
+// Contracts:
+// - save() fails, storing nothing, if the World has more bodies or pairs than the ring was sized for.
+// - restore() fails, leaving the World untouched, if the frame has been overwritten or the World's body ids
+//   no longer match ( bodies were created or destroyed since ). Fall back to a snapshot in that case.
+// - Restoring then stepping reproduces the original steps bit for bit.
+
+// Thread Safety:
+// - None, use from the physics thread.
+// ---
+
+#pragma once
+#include "core/World.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+struct BodyState{
+    Vec2 position;
+    Vec2 linearVelocity;
+    Real rotation;
+    Real angularVelocity;
+};
+
+class RollbackBuffer{
+
+    public:
+
+    RollbackBuffer(size_t frames, size_t maxBodies, size_t maxPairs);
+
+    bool save(const World& world, uint32_t frame); // Overwrites the oldest frame sharing the slot
+    bool restore(World& world, uint32_t frame) const;
+    bool contains(uint32_t frame) const;
+
+    size_t frames() const { return m_slots.size(); }
+    size_t frameBytes() const; // Storage per frame, for sizing
+
+    private:
+
+    struct Slot{
+        uint32_t frame{0};
+        bool valid{false};
+        uint32_t bodyCount{0};
+        uint32_t touchingCount{0};
+        uint32_t sensorCount{0};
+        uint64_t lastStateHash{0};
+    };
+
+    size_t m_maxBodies;
+    size_t m_maxPairs;
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_ids; // [frame slot][body]
+    std::vector<BodyState> m_states; // [frame slot][body]
+    std::vector<std::pair<uint32_t,uint32_t>> m_pairs; // [frame slot][touching, then sensor overlaps]
+
+};
@@ -0,0 +1,136 @@
+// TiledWorld.hpp
+
+// ---
+// Large worlds on top of a single World: the map is cut into square tiles, only the tiles around observers
+// are simulated, and the World's origin follows the first observer so simulated coordinates stay small.
+
+// Coordinates:
+// - A global position is a TilePosition, a tile plus an offset from that tile's lower-left corner, so it stays
+//   precise however far from the map origin it is. The World simulates in coordinates relative to origin(),
+//   the corner of one tile, and toSimulation()/toTile() convert between the two.
+// - Once the first observer is rebaseDistance tiles from the origin tile, update() moves the origin to the
+//   observer's tile through World::shiftOrigin(). Bodies and edges move with it.
+
+// Streaming:
+// - Tiles within activeRadius of any observer are active. Every update() groups the World's bodies by the
+//   tile their position falls in. A tile out of range is frozen once all its dynamic bodies are at rest
+//   ( slower than restSpeed ) or it has lingered maxLinger updates, so bodies in flight are not stopped mid-air.
+// - Freezing converts a tile's bodies to snapshot::BodyRecords ( io/Snapshot.hpp ) with tile-local positions
+//   and no world-space vertices, then removes them from the World. Thawing restores them in one batch.
+// - Bodies belong to whichever tile they are in when frozen, so they migrate between tiles as they move.
+
+// Ownership & Lifetime:
+// - TiledWorld holds a reference to the World, which must outlive it, and owns the frozen tiles.
+// - Frozen bodies do not keep their ids: thawing gives them fresh ones, so BodyHandles do not survive a freeze.
+
+// Contracts:
+// - Create the TiledWorld on an empty World ( or one whose origin is tile ( 0, 0 ) ) and add tiled bodies
+//   through createBodies(). Bodies added to the World directly are adopted by whichever tile they sit in.
+// - Edges ( World::createChain ) are not tiled, they stay in the World and only move with the origin.
+// - Frozen tiles are not part of World snapshots.
+// - The constructor disables the World's y cull ( World::setYBounds() ), which would otherwise remove every
+//   body in the tiles below y = -yBounds. update() culls instead: dynamic bodies more than cullDepth tiles
+//   below the lowest active tile have fallen out of the map and are destroyed ( counted in TileStats ).
+
+// Thread Safety:
+// - Not thread-safe, use from the physics thread between steps like the World itself.
+// ---
+
+#pragma once
+#include "core/World.hpp"
+#include "io/Snapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct TileCoord{
+    int32_t x{0};
+    int32_t y{0};
+
+    bool operator ==(const TileCoord& o) const { return x==o.x && y==o.y; }
+    bool operator !=(const TileCoord& o) const { return !(*this==o); }
+    bool operator <(const TileCoord& o) const { return y<o.y || (y==o.y && x<o.x); } // Row major
+};
+
+struct TilePosition{
+    TileCoord tile;
+    Vec2 local; // From the tile's lower-left corner, normally within [0, tileSize)
+};
+
+struct TileConfig{
+    Real tileSize{128.0f};
+    int32_t activeRadius{1}; // Tiles within this many tiles ( on either axis ) of an observer are simulated
+    int32_t rebaseDistance{2}; // Tiles the first observer may be from the origin tile before it moves
+    Real restSpeed{0.05f}; // Linear ( and angular ) speed under which an out of range body counts as at rest
+    uint32_t maxLinger{300}; // Updates an out of range tile may stay active while bodies in it still move
+    int32_t cullDepth{4}; // Tiles below the lowest active tile at which dynamic bodies are destroyed, 0 disables
+};
+
+struct TileStats{
+    size_t activeTiles{0};
+    size_t frozenTiles{0};
+    size_t frozenBodies{0};
+    uint32_t frozenThisUpdate{0}; // Tiles
+    uint32_t thawedThisUpdate{0};
+    uint32_t rebases{0}; // Origin shifts since construction
+    uint32_t culledThisUpdate{0}; // Bodies that fell below cullDepth
+    uint64_t culledBodies{0}; // Since construction
+};
+
+class TiledWorld{
+
+    public:
+
+    explicit TiledWorld(World& world, const TileConfig& config=TileConfig{});
+
+    // Bodies with positions local to tile. Bodies for an active tile go straight into the World,
+    // bodies for any other tile are frozen into it.
+    void createBodies(TileCoord tile, const BodyDef* defs, size_t count);
+
+    void setObservers(const TilePosition* observers, size_t count); // The first observer drives origin shifts
+    void update(); // Rebases, freezes and thaws, call between steps ( every step or every few )
+
+    TileCoord origin() const { return m_origin; }
+    Vec2 toSimulation(const TilePosition& position) const; // Into the World's current coordinates
+    TilePosition toTile(const Vec2& simulated) const;
+    TilePosition normalise(const TilePosition& position) const; // Moves local back into [0, tileSize)
+
+    bool isActive(TileCoord tile) const;
+    bool isFrozen(TileCoord tile) const;
+    const TileStats& stats() const { return m_stats; }
+    const TileConfig& config() const { return m_config; }
+
+    private:
+
+    struct FrozenTile{
+        TileCoord coord;
+        std::vector<snapshot::BodyRecord> records; // Positions local to the tile
+        std::vector<Vec2> vertices;
+        std::vector<uint32_t> children;
+    };
+
+    struct ActiveTile{
+        TileCoord coord;
+        uint32_t linger{0}; // Updates spent out of range
+    };
+
+    Vec2 tileOffset(TileCoord tile) const; // Lower-left corner of tile in simulated coordinates
+    TileCoord tileOf(const Vec2& simulated) const;
+    FrozenTile& frozenTile(TileCoord tile); // Finds or inserts
+    void freeze(FrozenTile& tile, const RigidBody& body, const Vec2& offset);
+    void wantedTiles(std::vector<TileCoord>& out) const;
+
+    World& m_world;
+    TileConfig m_config;
+    TileCoord m_origin;
+    std::vector<TilePosition> m_observers;
+    std::vector<ActiveTile> m_active; // Sorted by coord
+    std::vector<FrozenTile> m_frozen; // Sorted by coord
+    TileStats m_stats;
+
+    // Scratch reused across updates
+    std::vector<std::pair<TileCoord,uint32_t>> m_bodyTiles;
+    std::vector<TileCoord> m_wanted;
+    std::vector<Vec2> m_scratchTransformed;
+
+};
@@ -11,30 +11,35 @@
 #include "Vector2.hpp"
 #include "RigidBody.hpp"
 
-struct Transform{ 
+// Templated on the scalar like Vec2T, cos/sin resolve through argument dependent lookup so fixed point
+// transforms use the deterministic tables in core/Fixed.hpp. Transform is the Real instantiation.
+template <typename T>
+struct TransformT{ 
 
-    Vec2 position{0.0f,0.0f}; // Transform position 
-    float rotation{0.0f}; // Transform measured in radians  
+    Vec2T<T> position{}; // Transform position 
+    T rotation{0}; // Transform measured in radians  
 
-    Transform()=default;
-    Transform(const Vec2& position,float rotation) : position(position), rotation(rotation) {}
+    TransformT()=default;
+    TransformT(const Vec2T<T>& position,T rotation) : position(position), rotation(rotation) {}
 
     // Changes this transform's position 
-    void Translate(const Vec2& translation){ 
+    void Translate(const Vec2T<T>& translation){ 
         position.x+=translation.x;
         position.y+=translation.y;
     }
 
      // Changes this Transform's rotation 
-    void rotate(float translation){
+    void rotate(T translation){
         rotation+=translation; 
     }
 
     // Applies this transform to a local-space point, returning world-space.
-    Vec2 applyTransform(const Vec2& p) const { 
-        float c=std::cos(rotation);
-        float s=std::sin(rotation);
-        Vec2 rotated(
+    Vec2T<T> applyTransform(const Vec2T<T>& p) const { 
+        using std::cos;
+        using std::sin;
+        T c=cos(rotation);
+        T s=sin(rotation);
+        Vec2T<T> rotated(
             p.x * c - p.y * s,
             p.x * s + p.y * c 
         );
@@ -43,6 +48,8 @@ struct Transform{
 
 };
 
+using Transform=TransformT<Real>;
+
 namespace physEng{
 
     inline void worldSpace(RigidBody& body) { 
@@ -63,6 +70,7 @@ namespace physEng{
             body.transformedVertices.push_back(t.applyTransform(local));
         }
 
+        if (body.isCompound()) refreshChildBounds(body); // Cached piece boxes follow the vertices
         body.update = false; // Set cache update to false as the transformed vertices are up to date 
         
     }
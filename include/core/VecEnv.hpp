@@ -0,0 +1,103 @@
+// VecEnv.hpp
+
+// ---
+// Vectorised environment for reinforcement learning style loops: N Worlds reset, driven by one action array
+// and read back through one observation array per step, with no per-body calls from the caller.
+
+// Buffers ( row major, float regardless of Real ):
+// - Observations are [world][body][field] with kObservationFields fields per body ( see ObservationField ),
+//   maxBodies body slots per world. Each reset binds slot i to the handle of getBodies()[i], so slots follow
+//   creation order and keep describing the same body for the whole episode, however bodies are culled or
+//   destroyed meanwhile. A slot whose body is gone ( or was never there ) is written as zeros, so its
+//   ObserveAlive field tells it apart from a body at rest at the origin.
+// - Actions are [world][body][field] with kActionFields fields per body ( see ActionField ): an impulse
+//   applied to the body's velocity before the step. Static bodies and empty slots ignore theirs.
+// - step() and observe() write straight into the caller's buffer from the worker threads, each world into
+//   its own rows. The env also owns one observation buffer of the same layout, for callers ( and the C ABI )
+//   that want to wrap memory rather than provide it.
+
+// Ownership & Lifetime:
+// - The env owns a WorldBatch ( core/WorldBatch.hpp ) and its observation buffer. observations() stays valid
+//   for the env's lifetime.
+// - Caller buffers are only used during the call they are passed to.
+
+// Contracts:
+// - reset() clears a world to a fresh World and calls the ResetFn to populate it, from a worker thread. The
+//   ResetFn must only touch the world it is given ( and shared immutable data ).
+
+// Thread Safety:
+// - As WorldBatch: one caller thread at a time, nothing else touching the worlds during a call.
+// ---
+
+#pragma once
+#include "core/WorldBatch.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+enum ObservationField : uint32_t{
+    ObservePositionX,
+    ObservePositionY,
+    ObserveRotation,
+    ObserveVelocityX,
+    ObserveVelocityY,
+    ObserveAngularVelocity,
+    ObserveAlive, // 1 while the slot's body exists, 0 once it is destroyed or culled
+    kObservationFields
+};
+
+enum ActionField : uint32_t{
+    ActImpulseX, // Linear impulse, divided by mass
+    ActImpulseY,
+    ActAngularImpulse, // Divided by inertia
+    kActionFields
+};
+
+struct VecEnvConfig{
+    size_t worlds{1};
+    size_t threads{0}; // 0 uses every hardware thread
+    size_t maxBodies{1}; // Body slots per world in the buffers
+    Real dt{1.0f/60.0f};
+    int substeps{1}; // World steps per step() call
+};
+
+class VecEnv{
+
+    public:
+
+    using ResetFn=std::function<void(size_t index, World& world)>;
+
+    VecEnv(const VecEnvConfig& config, ResetFn reset);
+
+    size_t worldCount() const { return m_batch.size(); }
+    size_t observationSize() const { return m_batch.size()*m_config.maxBodies*kObservationFields; } // Floats
+    size_t actionSize() const { return m_batch.size()*m_config.maxBodies*kActionFields; }
+
+    void reset(); // Every world
+    void reset(const uint32_t* worlds, size_t count); // Only the listed worlds, e.g. finished episodes
+
+    // Applies actions ( nullptr for none ), advances every world by substeps, then writes observations
+    // ( nullptr for the env's own buffer ). Both buffers use the layouts above.
+    void step(const float* actions, float* observations=nullptr);
+    void observe(float* observations=nullptr); // Current state without stepping
+
+    const float* observations() const { return m_observations.data(); } // Written by step()/reset() when no buffer is given
+    float* observations() { return m_observations.data(); }
+
+    World& world(size_t index) { return m_batch.world(index); }
+    WorldBatch& batch() { return m_batch; }
+
+    private:
+
+    void bind(size_t index, const World& world); // Binds the world's slots to its first maxBodies bodies
+    void write(size_t index, const World& world, float* rows) const; // One world's maxBodies rows
+    void apply(size_t index, World& world, const float* rows) const;
+
+    VecEnvConfig m_config;
+    ResetFn m_reset;
+    WorldBatch m_batch;
+    std::vector<float> m_observations;
+    std::vector<BodyHandle> m_slots; // [world][slot], invalid for empty slots
+
+};
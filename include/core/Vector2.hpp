@@ -7,79 +7,108 @@
 // Usage:
 // - Represents positions, velocities, accelerations, forces, etc.
 // - This is a pure value type: no ownership, and no dynamic allocation.
+// - Vec2T<T> is the scalar generic template, Vec2 ( Real ) is what the engine stores.
 // -----
 
 #pragma once
+#include "core/Config.hpp"
 #include <cmath>
+#include <cstddef>
+#include <vector>
 
-struct Vec2{ 
+// The scalar is a template parameter so the same vector code runs on float and on fixed point
+// ( core/Fixed.hpp ) for lockstep determinism. The engine itself uses Vec2, the Real ( core/Config.hpp ) instantiation.
+// Square roots are found through argument dependent lookup, so scalar types bring their own.
+template <typename T>
+struct Vec2T{ 
 
-    float x{0.0f};
-    float y{0.0f};
-    Vec2()=default;
-    Vec2(float x,float y) : x(x), y(y) {}
+    T x{0};
+    T y{0};
+    Vec2T()=default;
+    Vec2T(T x,T y) : x(x), y(y) {}
 
     // Vector addition
-    Vec2 operator +(const Vec2& otherVector) const { // Add this vector with another 
-        return Vec2(x+otherVector.x,y+otherVector.y);
+    Vec2T operator +(const Vec2T& otherVector) const { // Add this vector with another 
+        return Vec2T(x+otherVector.x,y+otherVector.y);
     } 
 
     // Vector subtraction
-    Vec2 operator -(const Vec2& otherVector) const { 
-        return Vec2(x-otherVector.x,y-otherVector.y);
+    Vec2T operator -(const Vec2T& otherVector) const { 
+        return Vec2T(x-otherVector.x,y-otherVector.y);
     } 
 
     // Scalar multiplier 
-    Vec2 operator *(float scalar) const { 
-        return Vec2(x*scalar,y*scalar);
+    Vec2T operator *(T scalar) const { 
+        return Vec2T(x*scalar,y*scalar);
     }
      // Scalar division
-    Vec2 operator /(float scalar) const {
-        return Vec2(x/scalar,y/scalar);
+    Vec2T operator /(T scalar) const {
+        return Vec2T(x/scalar,y/scalar);
     }
 
     // Compound addition 
-    Vec2& operator +=(const Vec2& otherVector) { 
+    Vec2T& operator +=(const Vec2T& otherVector) { 
         x+=otherVector.x; y+=otherVector.y;
         return *this;
     };
 
     // Compound subtraction
-    Vec2& operator -=(const Vec2& otherVector) { 
+    Vec2T& operator -=(const Vec2T& otherVector) { 
         x-=otherVector.x; y-=otherVector.y;
         return *this;
     };
 
     // Compound multiplication
-    Vec2& operator*=(float scalar) {
+    Vec2T& operator*=(T scalar) {
         x *= scalar;
         y *= scalar;
         return *this;
     }
 
     // Check whether this vector and otherVector are exactly equivalent 
-    bool operator ==(const Vec2& otherVector) const { 
+    bool operator ==(const Vec2T& otherVector) const { 
         return ( (x==otherVector.x) && (y==otherVector.y )); 
     }
 
     // Get magnitude of this vector 
-    float length() const{
-        return std::sqrt(x*x + y*y);
+    T length() const{
+        using std::sqrt;
+        return sqrt(x*x + y*y);
     }
 
-    float lengthSquared() const{
+    T lengthSquared() const{
         return (x*x + y*y);
     }
 
     // Get unit vector and avoid division by zero
-    Vec2 normalise() const{ 
-        float len=length();
-        if (len > 1e-6f) {
-            return Vec2{x / len, y / len};
+    Vec2T normalise() const{ 
+        T len=length();
+        if (len > T(1e-6f)) {
+            return Vec2T{x / len, y / len};
         }
-        return Vec2{0.0f, 0.0f};
+        return Vec2T{T(0), T(0)};
     }
 
 };
 
+using Vec2=Vec2T<Real>;
 
+// Non-owning view of a run of vertices: a whole polygon, or one piece of a compound body.
+// Converts implicitly from a std::vector, so functions taking a span accept either.
+struct VertexSpan{
+
+    const Vec2* ptr{nullptr};
+    size_t count{0};
+
+    VertexSpan()=default;
+    VertexSpan(const Vec2* vertices,size_t n) : ptr(vertices), count(n) {}
+    VertexSpan(const std::vector<Vec2>& vertices) : ptr(vertices.data()), count(vertices.size()) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count==0; }
+    const Vec2* data() const { return ptr; }
+    const Vec2& operator[](size_t i) const { return ptr[i]; }
+    const Vec2* begin() const { return ptr; }
+    const Vec2* end() const { return ptr+count; }
+
+};
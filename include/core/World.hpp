@@ -7,21 +7,188 @@
 // - World owns all RigidBody instances stored in m_bodies.
 // - Bodies are stored by value for cache-friendly iteration.
 // - I havent safeguarded m_bodies, references/pointers to elements may be invalidated if m_bodies
-//   reallocates (e.g., when adding/removing bodies).
+//   reallocates (e.g., when adding/removing bodies). Use BodyHandle to refer to a body across steps.
+// - Every body gets a unique id on creation ( or on the next step if pushed through getBodies() ).
+//   Ids grow monotonically and removal keeps order, so m_bodies stays sorted by id and getBody()
+//   is a binary search.
 
 // The actual physics simulation :
 // - step(dt) advances the simulation by dt seconds
 //  this dt value is integrated in the step function to advance the simulation.
 
+// Persistence:
+// - saveSnapshot()/loadSnapshot() write and restore the full simulation state in the binary
+//   format described in io/Snapshot.hpp. Loading memory-maps the file and copies straight out of it.
+// - Restoring a snapshot gives bit-identical continuation of the saved World.
+
+// Recording:
+// - setRecorder() attaches a non-owning Recorder ( io/Recorder.hpp ), every step() then appends
+//   one delta-encoded frame of body transforms. Pass nullptr to detach.
+
+// Determinism:
+// - Candidate pairs are generated in a fixed order ( see collision/Partitioning.hpp ), so a given
+//   binary replays identically. Build with PHYS_DETERMINISTIC=ON to also pin floating point evaluation
+//   ( no FMA contraction ) so different compilers/targets agree.
+// - setDeterministic(true) hashes the body state after every step, read with lastStateHash().
+
+// Precision:
+// - All simulation state is Real ( core/Config.hpp ), float unless built with PHYS_DOUBLE_PRECISION=ON.
+//   Snapshots from one precision do not load into the other.
+
+// Spatial queries:
+// - rayCast()/rayCastAll()/rayCastMany(), queryAABB(), queryPoint() and shapeCast() walk the broad-phase grid left by the last step.
+//   step(), createBodies(), destroyBodies(), addBodies() and snapshot loads keep it current,
+//   call refreshBroadphase() after moving or adding bodies through getBodies() directly.
+
+// Continuous collision:
+// - Bodies flagged isBullet are swept from their start-of-step pose to their integrated position
+//   against every non-bullet body ( at its start-of-step pose ). On a hit the bullet only advances to
+//   the time of impact plus a small slop, and the regular solver resolves the contact. The rest of that
+//   step's motion is dropped, which is what keeps the global dt large without tunnelling.
+// - The sweep is translational, rotation is integrated normally.
+
+// Collision filtering:
+// - Each body's categoryBits/maskBits/groupIndex ( see RigidBody ) are copied into a compact array next
+//   to the AABBs, and filtered pairs are dropped during pair generation. Bullets honour the same filter.
+// - Spatial queries ignore filtering. queryAABB() and queryPoint() report every body, ray and shape casts
+//   skip sensors unless includeSensors is set, so trigger zones do not block line of sight.
+
+// Sensors:
+// - Bodies flagged isSensor skip the solver entirely. After each step every sensor is tested against
+//   the bodies overlapping its AABB with a boolean SAT test ( no manifold, no contacts ), and the
+//   begin/end changes since the previous step are batched into getSensorEvents().
+// - Sensors respect collision filters, do not detect other sensors, and still move under gravity
+//   unless static. Loading a snapshot re-seeds the overlap set without reporting events.
+
+// Contact events:
+// - With setContactEvents(true) the solver appends one ContactSample per resolved touching contact to a
+//   flat array. After the solve they are folded into per-step begin/end/impact arrays, read through
+//   getContactEvents() once step() returns. Speculative ( not yet touching ) contacts are not reported.
+// - Snapshots keep the touching set, the enable flag and the impact threshold, so the first step after a
+//   load reports only what changed since the save.
+// - A pre-solve filter can be compiled in through PHYS_PRESOLVE_HOOK, see narrowPhase().
+
+// Compound bodies:
+// - Bodies made of several convex pieces ( collision/Compound.hpp ) enter the grid with one whole-body AABB.
+//   Once a pair passes the AABB test, narrowPhase() walks each side's child tree and runs SAT only on piece
+//   pairs whose boxes overlap, every touching piece pair resolving as its own contact between the two bodies.
+// - Queries, sensors, bullets and edges all test the pieces, never the hull.
+
+// Edges and chains:
+// - createChain() adds static one-sided edges ( collision/Edge.hpp ) for terrain. Each segment is indexed on
+//   its own in a static BVH ( collision/StaticGeometry.hpp ), so a body only tests the segments near it.
+// - Big levels can be baked once with saveStaticGeometry() and memory-mapped by loadStaticGeometry().
+// - The bake is immutable and held by shared_ptr, so many Worlds can use one copy ( setStaticGeometry() ).
+//   Adding or removing chains in one World bakes it a private replacement and leaves the others alone.
+// - Edges respect collision filters, stop bullets and take part in speculative contacts. Ray casts and shape
+//   casts hit their front side ( walking the static BVH, the hit's chain is set ), region and point queries,
+//   sensors and contact events ignore them.
+
+// Speculative contacts:
+// - setSpeculativeContacts(true) is a cheaper alternative to bullets: every pair whose gap is smaller
+//   than its relative speed * dt gets a contact, and the solver only lets it close that gap.
+//   Nothing tunnels at one step per frame, at the cost of some extra narrow-phase work.
+
+// Forking:
+// - forkInto(dst) turns dst into a copy of this World for lookahead. If dst already holds the same bodies
+//   ( same ids, as after an earlier fork with nothing added or removed since ) only the mutable state is
+//   copied: poses, velocities, world-space vertices and child bounds, the broad-phase grid and the event
+//   state, all into storage dst already owns, so repeated forks allocate nothing. Local vertices, child
+//   trees, mass and material are treated as immutable and stay as dst has them. The static bake is shared.
+// - After changing a body's shape, mass, material, filter or flags through getBodies(), assign the World
+//   ( dst=src ) instead, which copies everything.
+// - dst keeps its own recorder.
+// - For rollback netcode, RollbackBuffer ( core/Rollback.hpp ) keeps a preallocated ring of the per-step
+//   state alone and restores a frame onto this World without allocating.
+
+// Large worlds:
+// - Bodies falling below y = -yBounds are removed each step ( setYBounds(), infinity disables the cull ).
+// - shiftOrigin() moves the coordinate origin: bodies, edges and the cull plane are all translated, so the
+//   simulation near the new origin regains full precision. TiledWorld ( core/TiledWorld.hpp ) drives it,
+//   together with freezing and thawing tiles of bodies around observers.
+
 // Thread Safety:
 // - World is NOT thread-safe.
 // - All access must occur from the physics thread.
+// - Exception: the const queries ( ray casts, queryAABB, queryPoint ) only read the World and allocate
+//   nothing shared, so any number of threads may run them concurrently between steps, as long as
+//   nothing mutates the World meanwhile.
+// - Separate Worlds share nothing mutable ( a shared StaticGeometry is immutable ), so each may be stepped on
+//   its own thread, see core/WorldBatch.hpp.
 // -------
 
 #pragma once
 #include "core/RigidBody.hpp"
 #include <vector>
 #include "stats/world_stats.hpp"
+#include "collision/Partitioning.hpp"
+#include "collision/Collision.hpp"
+#include "collision/Compound.hpp"
+#include "collision/Edge.hpp"
+#include "collision/StaticGeometry.hpp"
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace snapshot { class SnapshotView; }
+class Recorder;
+
+struct RayInput{
+    Vec2 from;
+    Vec2 to;
+};
+
+struct RayCastHit{
+    BodyHandle body; // Invalid when nothing or an edge was hit
+    ChainHandle chain; // The edge's chain when an edge was hit
+    int index{-1}; // Index into getBodies() at the time of the query, -1 for edges
+    Vec2 point;
+    Vec2 normal; // Outward surface normal at point
+    Real fraction{1.0f}; // Position along from->to, in [0, 1]
+};
+
+struct SensorEvent{
+    BodyHandle sensor;
+    BodyHandle visitor; // The non-sensor body entering or leaving
+    bool begin{true}; // false when the overlap ended ( including the visitor being destroyed or culled )
+};
+
+struct ContactPairEvent{
+    BodyHandle a; // a.id < b.id
+    BodyHandle b;
+};
+
+struct ContactImpactEvent{
+    BodyHandle a; // a.id < b.id
+    BodyHandle b;
+    Vec2 point; // World-space contact point ( midpoint for two-point manifolds )
+    Vec2 normal; // Unit normal pointing from a to b
+    Real impulse; // Normal impulse summed over the step's solver iterations
+};
+
+// Contact events from the last step, each array sorted by (a, b).
+struct ContactEvents{
+    std::vector<ContactPairEvent> begin; // Pairs touching now but not last step
+    std::vector<ContactPairEvent> end; // Pairs touching last step but not now ( including destroyed bodies )
+    std::vector<ContactImpactEvent> impacts; // Touching pairs whose impulse reached the impact threshold
+};
+
+// One resolved contact inside the solver, folded into ContactEvents after the step.
+struct ContactSample{
+    uint32_t a, b; // Body ids, a < b
+    Vec2 point;
+    Vec2 normal; // From a to b
+    Real impulse;
+};
+
+struct ShapeCastHit{
+    BodyHandle body; // Invalid when nothing or an edge was hit
+    ChainHandle chain; // The edge's chain when an edge was hit
+    int index{-1};
+    Vec2 point; // Touching point at the time of impact
+    Vec2 normal; // Unit normal pointing back at the cast shape, zero if it started overlapping
+    Real fraction{1.0f}; // Time of impact along from->to, in [0, 1]
+};
 
 class World{ 
 
@@ -29,18 +196,198 @@ class World{
 
     Vec2 getGravity() const{ return gravity; } 
     std::vector<RigidBody>& getBodies() { return m_bodies; } // Return rigid bodies in the world 
-    void step(float dt); // Step function for the world, called after each frame is rendered 
+    const std::vector<RigidBody>& getBodies() const { return m_bodies; }
+    void addBodies(std::vector<RigidBody>&& bodies); // Moves a batch of bodies in, growing storage at most once
+    void forkInto(World& dst) const; // Makes dst a copy of this World, cheaply when dst is an earlier fork ( see Forking )
+
+    // Bulk creation/destruction. Storage grows at most once per batch and bodies are constructed in place.
+    // outHandles ( optional ) receives one handle per def, in order. Invalid defs create no body and get an
+    // invalid handle: fewer than 3 vertices ( or none ), pieceCounts that do not sum to vertexCount, or a
+    // multi-shape def whose shapes cannot be composed ( a shape with fewer than 3 vertices, an empty list ).
+    BodyHandle createBody(const BodyDef& def);
+    void createBodies(const BodyDef* defs, size_t count, BodyHandle* outHandles=nullptr);
+    void createBodies(const std::vector<BodyDef>& defs, std::vector<BodyHandle>* outHandles=nullptr);
+    void destroyBodies(const BodyHandle* handles, size_t count); // Unknown/stale handles are ignored
+    void destroyBodies(const std::vector<BodyHandle>& handles) { destroyBodies(handles.data(), handles.size()); }
+
+    RigidBody* getBody(BodyHandle handle); // nullptr if the body no longer exists
+    const RigidBody* getBody(BodyHandle handle) const;
+
+    // Static terrain built from one-sided edges, see collision/Edge.hpp. Returns an invalid handle for bad defs.
+    // Every call rebakes the static BVH, so add large levels with one createChains() batch or a baked file.
+    ChainHandle createChain(const ChainDef& def);
+    void createChains(const ChainDef* defs, size_t count, ChainHandle* outHandles=nullptr);
+    void destroyChain(ChainHandle chain);
+    const StaticGeometry& getStaticGeometry() const { return *m_static; }
+    std::shared_ptr<const StaticGeometry> shareStaticGeometry() const { return m_static; }
+    void setStaticGeometry(std::shared_ptr<const StaticGeometry> geometry); // Shares a bake between Worlds, nullptr clears
+
+    void setYBounds(Real bounds) { m_yBounds=bounds; } // Cull depth, bodies below y = -bounds are removed
+    Real yBounds() const { return m_yBounds; }
+    void shiftOrigin(const Vec2& origin); // Makes origin ( in current coordinates ) the new ( 0, 0 )
+    bool saveStaticGeometry(const std::string& path) const; // Writes the edges and BVH as a bake
+    bool loadStaticGeometry(const std::string& path); // Maps a bake, replacing every edge
+
+    // Queries, defined in query.cpp
+    void refreshBroadphase(); // Rebuilds world-space vertices and the query grid
+    // Ray and shape casts pass through sensors unless includeSensors is set.
+    bool rayCast(const Vec2& from, const Vec2& to, RayCastHit& hit, bool includeSensors=false) const; // Closest hit along the segment
+    size_t rayCastAll(const Vec2& from, const Vec2& to, std::vector<RayCastHit>& hits, bool includeSensors=false) const; // Every body and edge hit, nearest first
+    void rayCastMany(const RayInput* rays, size_t count, RayCastHit* hits, bool includeSensors=false) const; // Closest hit per ray, hits[i].body and .chain invalid on a miss
+
+    // Region queries. The callback forms call fn(index, body) once per body and stop early when it returns false.
+    // The buffer forms write up to capacity handles and return the total number found ( which may exceed capacity ).
+    template <typename Fn> void queryAABB(const AABB& box, Fn&& fn) const; // Bodies whose AABB overlaps box
+    template <typename Fn> void queryPoint(const Vec2& point, Fn&& fn) const; // Bodies whose polygon contains point
+    size_t queryAABB(const AABB& box, BodyHandle* out, size_t capacity) const;
+    size_t queryPoint(const Vec2& point, BodyHandle* out, size_t capacity) const;
+
+    // Sweeps a convex polygon ( local-space vertices, fixed rotation ) from -> to and reports the first body it touches.
+    // ignore lets a body cast its own shape without hitting itself.
+    bool shapeCast(const std::vector<Vec2>& localVertices, Real rotation, const Vec2& from, const Vec2& to,
+                   ShapeCastHit& hit, BodyHandle ignore=BodyHandle{}, bool includeSensors=false) const;
+    void step(Real dt); // Step function for the world, called after each frame is rendered 
+    const std::vector<SensorEvent>& getSensorEvents() const { return m_sensorEvents; } // Produced by the last step, sorted by (sensor, visitor)
+
+    // Contact events are off by default, enabling them costs one array append per resolved contact.
+    void setContactEvents(bool enabled) { m_contactEventsEnabled=enabled; }
+    void setImpactThreshold(Real impulse) { m_impactThreshold=impulse; } // Minimum summed normal impulse for an impact event
+    const ContactEvents& getContactEvents() const { return m_contactEvents; }
     WorldStats& getStats() { return m_stats; } 
 
+    // Snapshots, defined in snapshot.cpp
+    bool saveSnapshot(const std::string& path) const; // Writes the world to path, returns success
+    bool loadSnapshot(const std::string& path); // Replaces this world with the snapshot at path, returns success
+    void writeSnapshot(std::vector<unsigned char>& out) const; // Serializes into an in-memory buffer ( e.g. for rollback )
+    bool restoreSnapshot(const snapshot::SnapshotView& view); // Replaces this world with an already validated snapshot
+
+    void setRecorder(Recorder* recorder) { m_recorder=recorder; } // Does not take ownership
+
+    void setSpeculativeContacts(bool enabled) { m_speculative=enabled; }
+    bool speculativeContacts() const { return m_speculative; }
+
+    void setDeterministic(bool enabled) { m_deterministic=enabled; }
+    bool isDeterministic() const { return m_deterministic; }
+    uint64_t stateHash() const; // Hash of every body's transform and velocities, bit exact
+    uint64_t lastStateHash() const { return m_lastStateHash; } // stateHash() after the last step in deterministic mode
+
     private:
 
+    friend class RollbackBuffer; // Saves and restores the mutable state directly, see core/Rollback.hpp
+
+    void assignIds(); // Gives ids to bodies pushed directly through getBodies()
+    Real bulletTimeOfImpact(int index, const Vec2& delta) const; // Fraction of delta a bullet can travel, see step()
+    void updateSensors(bool emitEvents); // Recomputes sensor overlaps, see step()
+    void updateContactEvents(); // Folds m_contactSamples into m_contactEvents, see step()
+    void edgePhase(Real dt); // Dynamic bodies against static edges, once per solver iteration
+    void rebuildStatic(std::vector<EdgeShape>&& edges); // Bakes a new, unshared StaticGeometry
+
     std::vector<RigidBody> m_bodies; // All rigid bodies, static and non-static, in the world ( Of which the world takes ownership)
     int solverIterations{10}; // Numver of times collisions are solved per step 
     Vec2 gravity{0.0f,-9.81f}; 
-    float m_yBounds=100.0f;
+    Real m_yBounds=100.0f;
     WorldStats m_stats;
+    uint32_t m_nextId{1};
+    Recorder* m_recorder=nullptr; // Optional transform recorder, not owned
+    bool m_deterministic{false};
+    bool m_speculative{false};
+    uint64_t m_lastStateHash{0};
+
+    // Broad-phase storage, reused between steps to avoid reallocating
+    partioning::SpatialGrid m_grid;
+    std::vector<AABB> m_aabbs;
+    std::vector<std::pair<int,int>> m_pairs;
+    std::vector<partioning::CollisionFilter> m_filters; // Parallel to m_aabbs during broadPhase
+
+    // Sensor overlaps as sorted (sensor id, visitor id), for this step and the previous one
+    std::vector<std::pair<uint32_t,uint32_t>> m_sensorOverlaps;
+    std::vector<std::pair<uint32_t,uint32_t>> m_prevSensorOverlaps;
+    std::vector<SensorEvent> m_sensorEvents;
+
+    // Contact events: raw solver samples, touching id pairs for this and the previous step, and the output
+    bool m_contactEventsEnabled{false};
+    Real m_impactThreshold{1.0f};
+    std::vector<ContactSample> m_contactSamples;
+    std::vector<std::pair<uint32_t,uint32_t>> m_touching;
+    std::vector<std::pair<uint32_t,uint32_t>> m_prevTouching;
+    ContactEvents m_contactEvents;
+
+    // Static edges and their BVH, kept apart from the body grid as they rarely change. Immutable once built and
+    // possibly shared with other Worlds, so every change builds a replacement ( see rebuildStatic() ).
+    std::shared_ptr<const StaticGeometry> m_static{std::make_shared<const StaticGeometry>()};
+    RigidBody m_edgeProxy; // Static stand-in for an edge when resolving its contacts
+    uint32_t m_nextChainId{1};
 
 };
 
+template <typename Fn>
+void World::queryAABB(const AABB& box, Fn&& fn) const{
+
+    // Visits the grid cells under box, clipped to the bounds of every body so huge ( or infinite ) boxes
+    // cost no more than the occupied area. A body covering several cells is only reported from the first
+    // cell its range shares with the query range, so no visited set is needed. When the box spans more
+    // cells than the grid holds entries ( sparse worlds, far apart bodies ) the bodies' cell ranges are
+    // scanned instead, so a query never costs more than one pass over the grid.
+
+    if (m_grid.bodyCount()!=m_bodies.size() || m_bodies.empty()) return; // Grid is stale, see refreshBroadphase()
+
+    const AABB& bounds=m_grid.bounds();
+    if (!(box.min.x<=bounds.max.x && box.min.y<=bounds.max.y && box.max.x>=bounds.min.x && box.max.y>=bounds.min.y)) return; // Also rejects NaN
+    const AABB clipped{Vec2(std::max(box.min.x,bounds.min.x),std::max(box.min.y,bounds.min.y)),
+                       Vec2(std::min(box.max.x,bounds.max.x),std::min(box.max.y,bounds.max.y))};
+
+    const Real cellSize=m_grid.config.cellSize;
+    const int x0=partioning::cellCoord(clipped.min.x,cellSize);
+    const int y0=partioning::cellCoord(clipped.min.y,cellSize);
+    const int x1=partioning::cellCoord(clipped.max.x,cellSize);
+    const int y1=partioning::cellCoord(clipped.max.y,cellSize);
+
+    const uint64_t cells=uint64_t(int64_t(x1)-x0+1)*uint64_t(int64_t(y1)-y0+1);
+    if (cells>m_grid.entries().size()){
+        for (int i=0;i<static_cast<int>(m_grid.bodyCount());++i){
+            const partioning::CellRange& r=m_grid.range(i);
+            if (r.x1<x0 || r.x0>x1 || r.y1<y0 || r.y0>y1) continue;
+            if (!AABBintersection(box,m_aabbs[i])) continue;
+            if (!fn(i,m_bodies[i])) return;
+        }
+        return;
+    }
+
+    for (int cy=y0;cy<=y1;++cy){
+        for (int cx=x0;cx<=x1;++cx){
+            auto [first,last]=m_grid.cell(cx,cy);
+            for (const auto* e=first;e!=last;++e){
+                const partioning::CellRange& r=m_grid.range(e->body);
+                if (cx!=std::max(x0,r.x0) || cy!=std::max(y0,r.y0)) continue;
+                if (!AABBintersection(box,m_aabbs[e->body])) continue;
+                if (!fn(e->body,m_bodies[e->body])) return;
+            }
+        }
+    }
+
+}
+
+template <typename Fn>
+void World::queryPoint(const Vec2& point, Fn&& fn) const{
+    queryAABB(AABB{point,point},[&](int index,const RigidBody& body){
+        const bool inside=!forEachPieceNear(body,AABB{point,point},[&](VertexSpan piece){ return !pointInPolygon(point,piece); });
+        if (!inside) return true;
+        return fn(index,body);
+    });
+}
+
 // The narrow phase for collision checking, using an expensive but definitive SAT test.
-bool narrowPhase(RigidBody& A,RigidBody& B, WorldStats& m_stats); 
+// speculativeMargin > 0 also resolves pairs separated by less than the margin ( speculative contacts ).
+// contacts, if non-null, receives a sample for each touching pair resolved ( see World::getContactEvents ).
+bool narrowPhase(RigidBody& A,RigidBody& B, WorldStats& m_stats, Real dt=0.0f, Real speculativeMargin=0.0f,
+                 std::vector<ContactSample>* contacts=nullptr);
+
+// Positional correction for a resolved manifold, shared by body and edge contacts.
+void correctPositions(Manifold& m);
+
+#ifdef PHYS_PRESOLVE_HOOK
+// Optional compile-time pre-solve filter ( configure with -DPHYS_PRESOLVE_HOOK=<function name> ).
+// Called for every colliding manifold before its impulses, return false to skip the contact.
+// The application defines it, it is a plain function call so the solver stays free of virtual dispatch.
+bool PHYS_PRESOLVE_HOOK(Manifold& manifold);
+#endif 
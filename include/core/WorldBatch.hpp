@@ -0,0 +1,98 @@
+// WorldBatch.hpp
+
+// ---
+// Farm mode: many small, independent Worlds stepped together across a thread pool, for parameter sweeps
+// and training runs where throughput in world-steps per second matters more than the latency of any one World.
+
+// Scheduling:
+// - One task per World. Each step() hands every worker a contiguous run of World indices, workers take tasks
+//   from the front of their own run and, once it is empty, steal single tasks from the back of another's.
+//   Worlds of very different sizes therefore even out without any tuning.
+// - The calling thread works as one of the pool's workers, so step() returns once every World has advanced.
+// - A World never moves between threads within a task, and Worlds share no mutable state, so results are
+//   bit identical to stepping the same Worlds one after another.
+
+// Sharing:
+// - setStaticGeometry() gives every World the same immutable edge bake ( see World::setStaticGeometry ).
+// - createBodies() adds the same body prototypes to every World. Vertex arrays stay with the caller's
+//   BodyDefs and each World computes mass properties once per run of identical prototypes.
+
+// Ownership & Lifetime:
+// - The batch owns its Worlds ( each in its own allocation, so neighbours never share cache lines ) and its
+//   worker threads, which sleep between calls and are joined on destruction.
+// - References from world() stay valid for the batch's lifetime.
+
+// Error Handling:
+// - An exception thrown by a task ( on any worker ) is caught there, the remaining tasks still run, and
+//   step()/parallelFor() rethrow the first one on the calling thread. The constructor joins any threads it
+//   started before rethrowing a failure to start the rest.
+
+// Thread Safety:
+// - step() and parallelFor() must be called from one thread at a time, and nothing else may touch the Worlds
+//   while they run. Between calls, world() may be used freely from the calling thread.
+// ---
+
+#pragma once
+#include "core/World.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorldBatch{
+
+    public:
+
+    explicit WorldBatch(size_t worldCount, size_t threadCount=0); // 0 uses every hardware thread
+    ~WorldBatch();
+    WorldBatch(const WorldBatch&)=delete;
+    WorldBatch& operator=(const WorldBatch&)=delete;
+
+    size_t size() const { return m_worlds.size(); }
+    size_t threadCount() const { return m_queues.size(); } // Including the calling thread
+    World& world(size_t index) { return *m_worlds[index]; }
+    const World& world(size_t index) const { return *m_worlds[index]; }
+
+    void setStaticGeometry(std::shared_ptr<const StaticGeometry> geometry);
+    void createBodies(const BodyDef* defs, size_t count);
+
+    void step(Real dt, int steps=1); // Advances every World by steps fixed steps of dt
+    void parallelFor(const std::function<void(size_t, World&)>& fn); // fn(index, world) once per World on the pool
+
+    uint64_t steals() const { return m_steals.load(std::memory_order_relaxed); } // Tasks taken from another worker so far
+
+    private:
+
+    struct alignas(64) WorkQueue{ // Own run of World indices, [begin, end)
+        std::mutex mutex;
+        uint32_t begin{0};
+        uint32_t end{0};
+    };
+
+    void run(const std::function<void(size_t, World&)>& fn);
+    void work(size_t self);
+    bool take(size_t self, uint32_t& task);
+    void workerLoop(size_t self);
+    void stop(); // Wakes and joins every worker
+
+    std::vector<std::unique_ptr<World>> m_worlds;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation{0}; // Bumped for every run, guarded by m_mutex
+    bool m_stop{false};
+    const std::function<void(size_t, World&)>* m_task{nullptr};
+    std::atomic<size_t> m_remaining{0};
+    std::atomic<uint64_t> m_steals{0};
+    std::exception_ptr m_error; // First exception thrown by a task in the current run, guarded by m_mutex
+
+};
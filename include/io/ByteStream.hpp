@@ -0,0 +1,67 @@
+// ByteStream.hpp
+
+// ---
+// Small helpers for compact byte encodings ( zigzag + LEB128 varints ) and quantization.
+// Shared by the recorder and anything else that streams delta-encoded state.
+
+// Contracts:
+// - readVarint/readZigzag never read past end, on truncated input they return false.
+// ---
+
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <vector>
+
+namespace bytes {
+
+// Maps signed to unsigned so small magnitudes ( of either sign ) give small varints
+inline uint64_t zigzagEncode(int64_t v){
+    return (uint64_t(v) << 1) ^ uint64_t(v >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t v){
+    return int64_t(v >> 1) ^ -int64_t(v & 1);
+}
+
+inline void writeVarint(std::vector<unsigned char>& out,uint64_t v){
+    while (v >= 0x80){
+        out.push_back(static_cast<unsigned char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<unsigned char>(v));
+}
+
+inline void writeZigzag(std::vector<unsigned char>& out,int64_t v){
+    writeVarint(out,zigzagEncode(v));
+}
+
+inline bool readVarint(const unsigned char*& cursor,const unsigned char* end,uint64_t& v){
+    v=0;
+    for (int shift=0;shift<64 && cursor<end;shift+=7){
+        unsigned char byte=*cursor++;
+        v |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+inline bool readZigzag(const unsigned char*& cursor,const unsigned char* end,int64_t& v){
+    uint64_t raw;
+    if (!readVarint(cursor,end,raw)) return false;
+    v=zigzagDecode(raw);
+    return true;
+}
+
+// Quantizes value onto a grid of the given step ( step > 0 ). Taken and returned as double so either
+// precision of Real round trips without an intermediate float.
+inline int64_t quantize(double value,double step){
+    return static_cast<int64_t>(std::llround(value/step));
+}
+
+inline double dequantize(int64_t q,double step){
+    return static_cast<double>(q)*step;
+}
+
+} // namespace bytes
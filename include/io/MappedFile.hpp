@@ -0,0 +1,43 @@
+// MappedFile.hpp
+
+// ---
+// Read-only memory mapping of a file, used to load binary data (snapshots etc.) without parsing.
+
+// Ownership & Lifetime:
+// - MappedFile owns the mapping and releases it in the destructor ( RAII ).
+// - Pointers returned by data() are only valid while the MappedFile is alive.
+// - Copying is disabled, moving transfers ownership of the mapping.
+
+// Error Handling:
+// - open() returns false if the file cannot be opened or mapped, data() is then nullptr.
+// ---
+
+#pragma once
+#include <cstddef>
+#include <string>
+
+class MappedFile{
+
+    public:
+
+    MappedFile()=default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)=delete;
+    MappedFile& operator=(const MappedFile&)=delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path); // Maps the whole file read-only, returns success
+    void close(); // Releases the mapping, safe to call when nothing is mapped
+
+    const unsigned char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool isOpen() const { return m_data!=nullptr; }
+
+    private:
+
+    const unsigned char* m_data=nullptr;
+    size_t m_size=0;
+
+};
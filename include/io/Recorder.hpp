@@ -0,0 +1,172 @@
+// Recorder.hpp
+
+// ---
+// Streams per-step body transforms ( position + rotation ) to a file or pipe.
+
+// Stream layout:
+//   [RecordingHeader]
+//   [BlockHeader][block payload] ...
+// A block holds whole frames. Every keyframe starts a new block, so a reader can seek by
+// hopping from block header to block header without decoding payloads.
+// Block payloads are LZ77 compressed ( see recording::compress ) when RecorderConfig::compress is set and
+// that shrinks them, BlockHeader::rawBytes then holds the decoded size. Otherwise rawBytes is 0 and the
+// payload is the frames as they are.
+// Frame payload ( varints, see io/ByteStream.hpp ), bodies always in ascending id order:
+//   keyframe : type=1, bodyCount, then per body: id gap since the previous body, zigzag(x,y,rotation)
+//   delta    : type=0, bodyCount, changedCount, then per changed body:
+//              id gap since the previous changed body, zigzag(dx,dy,drotation)
+// Bodies are keyed by RigidBody::id ( the id in a BodyHandle ), not by their index in the World, which
+// shifts when bodies are removed. A keyframe carries the id table and is forced whenever the set of
+// ids differs from the previous frame, so a delta only ever refers to bodies the reader already has.
+// Values are quantized to the configured precision and deltas are taken against the
+// previous quantized frame, so error never accumulates. Bodies whose quantized transform
+// did not change ( statics, resting bodies ) are not written at all in delta frames.
+
+// Error Handling:
+// - open() returns false if the file cannot be created. The first failed write ( full disk, closed pipe )
+//   stops the recording, later frames are dropped and ok() turns false, so a truncated file is never
+//   mistaken for a complete one.
+
+// Ownership & Lifetime:
+// - A Recorder opened on a path owns the FILE and closes it, one opened on a stream does not.
+// - World holds a non-owning pointer, the Recorder must outlive its attachment.
+
+// Thread Safety:
+// - Not thread-safe, recordFrame() is called from World::step() on the physics thread.
+// ---
+
+#pragma once
+#include "core/RigidBody.hpp"
+#include "io/MappedFile.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+struct RecorderConfig{
+    float positionPrecision=0.001f; // World units per quantization step
+    float rotationPrecision=0.0001f; // Radians per quantization step
+    uint32_t keyframeInterval=240; // Frames between keyframes ( seek granularity )
+    uint32_t blockBytes=64*1024; // Payload size at which a block is flushed
+    bool compress=true; // LZ77 compress block payloads, resting bodies repeat the same bytes frame after frame
+};
+
+namespace recording {
+
+constexpr uint32_t kRecordingMagic=0x43455250; // "PREC"
+constexpr uint32_t kBlockMagic=0x4B4C4250; // "PBLK"
+constexpr uint32_t kRecordingVersion=3;
+
+struct RecordingHeader{
+    uint32_t magic{kRecordingMagic};
+    uint32_t version{kRecordingVersion};
+    float positionPrecision{0.0f};
+    float rotationPrecision{0.0f};
+    uint32_t keyframeInterval{0};
+    uint32_t reserved{0};
+};
+
+struct BlockHeader{
+    uint32_t magic{kBlockMagic};
+    uint32_t firstFrame{0};
+    uint32_t frameCount{0};
+    uint32_t payloadBytes{0};
+    uint32_t startsWithKeyframe{0};
+    uint32_t rawBytes{0}; // Decoded payload size of a compressed block, 0 for a stored one
+};
+
+struct QuantizedTransform{
+    uint32_t id{0}; // RigidBody::id, not part of the comparison below
+    int64_t x{0};
+    int64_t y{0};
+    int64_t rotation{0};
+    bool operator==(const QuantizedTransform& o) const { return x==o.x && y==o.y && rotation==o.rotation; }
+    bool operator!=(const QuantizedTransform& o) const { return !(*this==o); }
+};
+
+// Decodes one frame from payload into state ( which holds the previous frame for deltas, ascending by id ).
+// Returns false on malformed input, including deltas naming an id the last keyframe did not list.
+bool decodeFrame(const unsigned char*& cursor,const unsigned char* end,std::vector<QuantizedTransform>& state);
+
+// Block compression: greedy LZ77 over 4 byte matches, as sequences of
+//   varint literal count, literals, varint ( match length - 4 ), varint match offset
+// where the last sequence stops after its literals. decompress() returns false unless the input decodes
+// to exactly rawBytes bytes.
+void compress(const unsigned char* data,size_t size,std::vector<unsigned char>& out);
+bool decompress(const unsigned char* data,size_t size,size_t rawBytes,std::vector<unsigned char>& out);
+
+} // namespace recording
+
+class Recorder{
+
+    public:
+
+    Recorder()=default;
+    ~Recorder();
+
+    Recorder(const Recorder&)=delete;
+    Recorder& operator=(const Recorder&)=delete;
+
+    bool open(const std::string& path,const RecorderConfig& config={}); // Creates/truncates path
+    bool open(std::FILE* stream,const RecorderConfig& config={}); // Writes to an existing stream ( e.g. a pipe )
+    void close(); // Flushes the pending block, closes owned files
+
+    // Appends one frame for the current body transforms
+    void recordFrame(const std::vector<RigidBody>& bodies);
+
+    uint64_t framesRecorded() const { return m_frame; }
+    uint64_t bytesWritten() const { return m_bytesWritten; }
+    bool ok() const { return !m_failed; } // False once a write failed, nothing is recorded after that
+
+    private:
+
+    void beginStream();
+    void flushBlock();
+    void write(const void* data,size_t size); // Sets m_failed on a short write
+
+    std::FILE* m_file=nullptr;
+    bool m_ownsFile=false;
+    bool m_failed=false;
+    RecorderConfig m_config;
+
+    uint32_t m_frame=0;
+    uint32_t m_blockFirstFrame=0;
+    uint32_t m_blockFrames=0;
+    bool m_blockKeyframe=false;
+    uint64_t m_bytesWritten=0;
+
+    std::vector<recording::QuantizedTransform> m_previous; // Last written quantized frame, ascending by id
+    std::vector<recording::QuantizedTransform> m_current;
+    std::vector<unsigned char> m_block; // Pending block payload
+    std::vector<unsigned char> m_compressed;
+
+};
+
+// Reads a recording back, with keyframe seeking. The file is memory-mapped.
+class RecordingReader{
+
+    public:
+
+    bool open(const std::string& path);
+
+    const recording::RecordingHeader& header() const { return m_header; }
+    uint32_t frameCount() const { return m_frameCount; }
+
+    // Decodes frame into world-space transforms, one entry per body in ascending id order.
+    // Seeks from the nearest keyframe at or before frame. Returns false if frame is out of range.
+    bool readFrame(uint32_t frame,std::vector<uint32_t>& ids,std::vector<Vec2>& positions,std::vector<Real>& rotations);
+
+    private:
+
+    struct BlockRef{
+        recording::BlockHeader header;
+        size_t payloadOffset;
+    };
+
+    MappedFile m_file;
+    recording::RecordingHeader m_header;
+    std::vector<unsigned char> m_decompressed; // Payload of the block being decoded, when compressed
+    std::vector<BlockRef> m_blocks;
+    uint32_t m_frameCount=0;
+
+};
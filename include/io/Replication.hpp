@@ -0,0 +1,197 @@
+// Replication.hpp
+
+// ---
+// Server to client state replication over UDP: every client receives its own view of the World ( the bodies
+// within an interest radius of its observer ), quantized and delta-compressed against the last view it
+// acknowledged.
+
+// Datagrams ( varints and zigzag varints, see io/ByteStream.hpp ):
+//   header   : magic ( 4 bytes, native order ), type ( 1 byte )
+//   ack      : type=1, client -> server. Nonce ( 4 bytes, native order, 0 before a challenge ), acknowledged
+//              sequence ( 0 for none ), zigzag observer x, y in kObserverStep units. An ack carrying the
+//              endpoint's nonce registers the client, repeated acks keep it registered.
+//   challenge: type=3, server -> client. The nonce for the ack's source endpoint ( 4 bytes, native order ),
+//              sent in reply to any ack with the wrong one. Always smaller than the ack that caused it.
+//   view     : type=2, server -> client. sequence, baseline sequence ( 0 for none ), then for a baseline of 0
+//              the position and rotation precision ( float, native order ). Then bodyCount and per body,
+//              ascending by id: varint ( id gap << 1 | changed ), followed when changed by zigzag(x, y, rotation),
+//              as deltas from the baseline's quantized values for bodies in the baseline and absolute otherwise.
+// A view lists the whole interest set, so bodies in the baseline but missing from the view have left it.
+// Bodies whose quantized transform matches the baseline cost one byte. As in the recorder, deltas are taken
+// between quantized values, so error never accumulates.
+
+// Interest management:
+// - Each client's view is gathered with World::queryAABB() around its observer ( the broad-phase grid ), cut
+//   to the interest radius and, beyond maxBodies, to the nearest bodies. A view that still encodes to more
+//   than kMaxDatagram bytes loses its farthest bodies until it fits ( counted in truncatedViews ).
+// - The server remembers the last history views per client and deltas against the newest one the client has
+//   acknowledged. Lost datagrams just mean an older baseline, an ack older than the history an absolute view.
+
+// Registration:
+// - A client is only registered, and only sent views, once it has echoed the nonce for its endpoint, which
+//   proves it receives at the address it sends from. Nonces are a keyed hash of the endpoint, so unverified
+//   senders cost the server no state, and spoofed sources cannot turn it into a traffic amplifier.
+// - At most maxClients are registered at once, further endpoints are ignored ( counted in rejectedClients )
+//   until one times out.
+// - open() binds to loopback unless given another interface address ( "0.0.0.0" for every interface ).
+
+// Ownership & Lifetime:
+// - Server and client each own their socket. Client state lives in the server until it times out.
+
+// Thread Safety:
+// - Not thread-safe. The server only reads the World ( between steps ), so it may run on the physics thread
+//   or on another thread while the World is not being stepped.
+
+// Error Handling:
+// - open()/connect() return false if the socket cannot be opened. Malformed, foreign or stale datagrams are
+//   dropped and counted.
+// ---
+
+#pragma once
+#include "core/World.hpp"
+#include "io/UdpSocket.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace replication {
+
+constexpr uint32_t kReplicationMagic=0x4C505250; // "PRPL"
+constexpr uint8_t kAckPacket=1;
+constexpr uint8_t kViewPacket=2;
+constexpr uint8_t kChallengePacket=3;
+constexpr float kObserverStep=0.01f; // Units of observer positions in acks
+constexpr int kAckRetryMs=100; // A client with no new view acks again after this long
+constexpr size_t kMaxDatagram=1400;
+constexpr size_t kMaxViewHeader=26; // Magic, type, sequence, baseline, precisions and body count at their largest
+constexpr size_t kMaxViewBodies=kMaxDatagram-kMaxViewHeader; // One byte each, when every body is unchanged
+
+struct QuantizedBody{ // A body as a view carries it
+    uint32_t id;
+    int64_t x, y, rotation;
+};
+
+} // namespace replication
+
+struct ReplicationConfig{
+    Real interestRadius{25.0f};
+    size_t maxBodies{96}; // Per view, nearest first. Clamped to kMaxViewBodies
+    float positionPrecision=0.01f; // World units per quantization step
+    float rotationPrecision=0.001f; // Radians per quantization step
+    uint32_t history{32}; // Views remembered per client for delta baselines
+    uint32_t timeout{300}; // Broadcasts without an ack before a client is dropped
+    size_t maxClients{256}; // Registered at once, acks from further endpoints are ignored
+};
+
+struct ReplicationStats{
+    size_t clients{0};
+    uint64_t packetsSent{0};
+    uint64_t bytesSent{0};
+    uint64_t bodiesSent{0};
+    uint64_t changedBodies{0}; // Bodies that needed a transform ( the rest cost one byte )
+    uint64_t absoluteViews{0}; // Views sent without a baseline
+    uint64_t truncatedViews{0}; // Views cut short of maxBodies to fit kMaxDatagram
+    uint64_t dropped{0}; // Datagrams rejected
+    uint64_t challenges{0}; // Acks answered with a challenge ( new or unverified endpoints )
+    uint64_t rejectedClients{0}; // Verified acks ignored because maxClients were registered
+};
+
+class ReplicationServer{
+
+    public:
+
+    explicit ReplicationServer(const ReplicationConfig& config=ReplicationConfig{});
+
+    bool open(uint16_t port, const std::string& address="127.0.0.1"); // 0 for an ephemeral port, see port()
+    uint16_t port() const { return m_socket.localPort(); }
+
+    void poll(); // Reads every waiting ack, challenging unverified endpoints and registering verified ones
+    void broadcast(const World& world); // Sends one view per client, the World's broad-phase must be current
+
+    const ReplicationStats& stats() const { return m_stats; }
+
+    private:
+
+    struct View{
+        uint32_t sequence{0};
+        std::vector<replication::QuantizedBody> bodies; // Ascending by id
+    };
+
+    struct Client{
+        Endpoint endpoint;
+        Vec2 observer{0.0f,0.0f};
+        uint32_t acked{0};
+        uint32_t lastHeard{0}; // Broadcast sequence of the last ack
+        std::vector<View> history; // Ring indexed by sequence % config.history
+    };
+
+    void gather(const World& world, const Client& client); // Into m_gathered, nearest first
+    const View* baseline(const Client& client) const;
+    size_t encode(const View& view, const View* base); // Into m_packet
+    uint32_t nonce(const Endpoint& endpoint) const;
+
+    ReplicationConfig m_config;
+    uint64_t m_secret{0}; // Keys the endpoint nonces, random per server
+    UdpSocket m_socket;
+    std::vector<Client> m_clients; // Sorted by endpoint
+    uint32_t m_sequence{0};
+    ReplicationStats m_stats;
+
+    // Scratch reused across broadcasts
+    std::vector<std::pair<Real,uint32_t>> m_nearest;
+    std::vector<replication::QuantizedBody> m_gathered;
+    std::vector<unsigned char> m_packet;
+
+};
+
+struct ReplicatedBody{
+    uint32_t id;
+    Vec2 position;
+    Real rotation; // Wrapped to ( -pi, pi ]
+};
+
+class ReplicationClient{
+
+    public:
+
+    explicit ReplicationClient(uint32_t history=32);
+
+    bool connect(const std::string& host, uint16_t port); // Opens a socket and starts registering with an ack
+    void setObserver(const Vec2& position) { m_observer=position; }
+    // Answers challenges and decodes waiting views, acknowledging the newest, true if the view changed. Without
+    // a new view the last ack is repeated every kAckRetryMs, which registers the client again after a lost
+    // ack or challenge or a server timeout, so poll() regularly.
+    bool poll();
+
+    const std::vector<ReplicatedBody>& bodies() const { return m_bodies; } // Ascending by id
+    uint32_t sequence() const { return m_latest; }
+    uint64_t bytesReceived() const { return m_bytesReceived; }
+    uint64_t dropped() const { return m_dropped; }
+
+    private:
+
+    struct View{
+        uint32_t sequence{0};
+        std::vector<replication::QuantizedBody> bodies;
+    };
+
+    bool decode(const unsigned char* data, size_t size);
+    void sendAck();
+
+    UdpSocket m_socket;
+    Endpoint m_server;
+    uint32_t m_nonce{0}; // From the server's last challenge
+    Vec2 m_observer{0.0f,0.0f};
+    std::vector<View> m_history; // Ring indexed by sequence % size
+    uint32_t m_latest{0};
+    float m_positionPrecision{0.0f};
+    float m_rotationPrecision{0.0f};
+    std::vector<ReplicatedBody> m_bodies;
+    uint64_t m_bytesReceived{0};
+    uint64_t m_dropped{0};
+    std::chrono::steady_clock::time_point m_lastAck;
+    std::vector<unsigned char> m_packet;
+
+};
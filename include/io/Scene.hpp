@@ -0,0 +1,109 @@
+// Scene.hpp
+
+// ---
+// Scene descriptions: shapes, materials and body instances, loaded in bulk into a World.
+
+// Text format ( .scene ), one declaration per line, '#' starts a comment:
+//   shape <name> box <width> <height>
+//   shape <name> ngon <sides> <radius>
+//   shape <name> poly <x0> <y0> <x1> <y1> ...      convex ( rejected otherwise ), any winding, recentred on its centroid
+//   material <name> <density> <staticFriction> <dynamicFriction> <restitution>
+//   bodies <count>                                  optional, reserves storage up front
+//   body <shape> <material> <x> <y> [key=value ...]
+// Optional body keys: rot, vx, vy, w ( angular velocity ), mass ( overrides density ),
+// static ( 0/1 ), sensor ( 0/1 ), colour=r,g,b and the collision filter category, mask ( decimal or 0x hex ) and group. Shapes and materials must be declared before use.
+
+// Binary format ( .bscene ): [SceneHeader][Vec2 vertices][SceneShape][MaterialDef][BodyInstance],
+// each section 8 byte aligned at the offset stored in the header. loadBinary() maps the file
+// and instantiates straight from the mapped sections. Vertices and body state are stored as Real, so a
+// binary scene only loads into a build of the same precision ( text scenes load into either ).
+
+// Error Handling:
+// - All loaders return false on failure and, if error is non-null, describe the problem
+//   ( with the line number for text scenes ). The World is left untouched on failure.
+// ---
+
+#pragma once
+#include "core/RigidBody.hpp"
+#include "core/Vector2.hpp"
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+class World;
+
+namespace scene {
+
+constexpr uint32_t kSceneMagic=0x4E435342; // "BSCN"
+constexpr uint32_t kSceneVersion=4;
+
+struct SceneShape{
+    uint32_t firstVertex{0}; // Into the scene's vertex array, local space about the COM
+    uint32_t vertexCount{0};
+    int32_t shape{Polygon}; // ShapeType
+    int32_t sides{0};
+};
+
+struct MaterialDef{
+    float density{1.0f};
+    float staticFriction{0.2f};
+    float dynamicFriction{0.8f};
+    float restitution{0.0f};
+};
+
+struct BodyInstance{
+    uint32_t shape{0};
+    uint32_t material{0};
+    Vec2 position;
+    Real rotation{0.0f};
+    Vec2 linearVelocity;
+    Real angularVelocity{0.0f};
+    Real mass{0.0f}; // <= 0 means derive from material density
+    Colour colour{255.0f,255.0f,255.0f};
+    uint32_t isStatic{0};
+    uint16_t categoryBits{0x0001};
+    uint16_t maskBits{0xFFFF};
+    int16_t groupIndex{0};
+    uint16_t isSensor{0};
+};
+
+struct SceneHeader{
+    uint32_t magic{kSceneMagic};
+    uint32_t version{kSceneVersion};
+    uint32_t scalarSize{sizeof(Real)}; // Must match the build's Real ( see core/Config.hpp )
+    uint32_t reserved{0};
+    uint64_t vertexCount{0};
+    uint64_t shapeCount{0};
+    uint64_t materialCount{0};
+    uint64_t instanceCount{0};
+    uint64_t vertexOffset{0};
+    uint64_t shapeOffset{0};
+    uint64_t materialOffset{0};
+    uint64_t instanceOffset{0};
+};
+
+struct Scene{
+    std::vector<Vec2> vertices;
+    std::vector<SceneShape> shapes;
+    std::vector<MaterialDef> materials;
+    std::vector<BodyInstance> instances;
+};
+
+// Parses a text scene, line by line
+bool parseText(std::istream& in,Scene& out,std::string* error=nullptr);
+bool loadText(const std::string& path,Scene& out,std::string* error=nullptr);
+
+// Writes a scene in the binary format ( e.g. to convert authored text scenes once )
+bool saveBinary(const Scene& scene,const std::string& path);
+
+// Adds every instance of the scene to world in one batch
+bool instantiate(const Scene& scene,World& world,std::string* error=nullptr);
+
+// Maps a binary scene and adds its instances to world in one batch
+bool loadBinary(const std::string& path,World& world,std::string* error=nullptr);
+
+// Loads either format into world, picking binary by its magic number
+bool loadScene(const std::string& path,World& world,std::string* error=nullptr);
+
+} // namespace scene
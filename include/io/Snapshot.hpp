@@ -0,0 +1,150 @@
+// Snapshot.hpp
+
+// ---
+// Versioned binary snapshot format for a World ( bodies, shapes and solver state ).
+
+// Layout ( all sections are tightly packed, native endianness ):
+//   [SnapshotHeader]
+//   [BodyRecord  x header.bodyCount]
+//   [Vec2        x header.vertexCount]   local-space vertices of every body, back to back
+//   [Vec2        x header.transformedCount]  cached world-space vertices of every body
+//   [EdgeShape   x header.edgeCount]   static terrain edges, stored verbatim
+//   [uint32_t    x header.childCount]   piece vertex counts of compound bodies, back to back
+//   [uint32_t    x 2*header.touchingCount]   touching body pairs ( id a, id b ) of the last step, sorted
+// Every record stores offsets into the vertex sections, so a mapped file can be
+// read in place without any parsing ( see SnapshotView ).
+
+// Contracts:
+// - A restored World continues bit-identically to the World that was saved, as every
+//   field that feeds World::step() ( including cached transformedVertices ) is stored verbatim.
+// - Snapshots are not portable across endianness or scalar precision, the header records
+//   both and SnapshotView rejects mismatches.
+// - Bump kSnapshotVersion whenever BodyRecord or SnapshotHeader change.
+// ---
+
+#pragma once
+#include "core/RigidBody.hpp"
+#include "core/Vector2.hpp"
+#include "collision/Edge.hpp"
+#include "stats/world_stats.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace snapshot {
+
+constexpr uint32_t kSnapshotMagic=0x50414E53; // "SNAP"
+constexpr uint32_t kSnapshotVersion=10;
+constexpr uint32_t kEndianTag=0x01020304;
+
+struct SnapshotHeader{
+    uint32_t magic{kSnapshotMagic};
+    uint32_t version{kSnapshotVersion};
+    uint32_t endianTag{kEndianTag};
+    uint32_t scalarSize{sizeof(Real)};
+    uint32_t headerSize{0};
+    uint32_t bodyRecordSize{0};
+    uint64_t bodyCount{0};
+    uint64_t vertexCount{0};
+    uint64_t transformedCount{0};
+    uint64_t edgeCount{0};
+    uint32_t edgeRecordSize{0};
+    uint32_t nextChainId{1};
+    uint64_t childCount{0};
+
+    // Solver state
+    Real gravityX{0.0f};
+    Real gravityY{0.0f};
+    Real yBounds{0.0f};
+    int32_t solverIterations{0};
+    WorldStats stats{};
+    uint32_t nextBodyId{1};
+    uint32_t reserved{0};
+
+    // Contact events, so the first step after a load reports only changes
+    double impactThreshold{1.0}; // Real, widened so the header has no padding in either precision
+    uint64_t touchingCount{0};
+    uint32_t contactEvents{0};
+    uint32_t reserved2{0};
+
+    // Step settings and the replay hash chain
+    uint64_t lastStateHash{0};
+    uint32_t speculative{0};
+    uint32_t deterministic{0};
+};
+
+struct BodyRecord{ // Flat, trivially copyable mirror of RigidBody
+    int32_t shape;
+    int32_t sides;
+    int32_t radius;
+    Vec2 force;
+    Vec2 position;
+    Real rotation;
+    Vec2 linearVelocity;
+    Vec2 linearAcceleration;
+    Real angularVelocity;
+    Real angularAcceleration;
+    Colour colour;
+    Real inertia;
+    Real inverseInertia;
+    Real staticFriction;
+    Real dynamicFriction;
+    Real density;
+    Real mass;
+    Real inverseMass;
+    Real restitution;
+    Real area;
+    uint8_t isStatic;
+    uint8_t update;
+    uint8_t isBullet;
+    uint8_t isSensor;
+    uint16_t categoryBits;
+    uint16_t maskBits;
+    int16_t groupIndex;
+    uint16_t pad2;
+    uint32_t vertexCount;
+    uint64_t firstVertex; // Index into the local vertex section
+    uint32_t transformedCount;
+    uint32_t id; // BodyHandle id
+    uint64_t firstTransformed; // Index into the transformed vertex section
+    uint32_t childCount; // Pieces of a compound body, 0 for a single polygon
+    uint32_t pad3;
+    uint64_t firstChild; // Index into the child section
+};
+
+// Converts a body to its record, appending its vertices and piece counts to the given arrays.
+BodyRecord makeRecord(const RigidBody& body,std::vector<Vec2>& vertices,std::vector<Vec2>& transformed,std::vector<uint32_t>& children);
+
+// Rebuilds a body from a record and the sections it points into. Compound bodies rebuild their child tree.
+void restoreRecord(const BodyRecord& record,const Vec2* vertices,const Vec2* transformed,const uint32_t* children,RigidBody& body);
+
+// Read-only, zero-copy view over a serialized snapshot ( a mapped file or an in-memory buffer ).
+// The view does not own the bytes, they must outlive it.
+class SnapshotView{
+
+    public:
+
+    // Validates the header and section sizes, returns false for foreign or truncated data
+    bool open(const unsigned char* data,size_t size);
+
+    const SnapshotHeader& header() const { return *m_header; }
+    const BodyRecord* bodies() const { return m_bodies; }
+    const Vec2* vertices() const { return m_vertices; }
+    const Vec2* transformedVertices() const { return m_transformed; }
+    const EdgeShape* edges() const { return m_edges; }
+    const uint32_t* children() const { return m_children; }
+    const uint32_t* touching() const { return m_touching; } // 2 * header().touchingCount ids
+
+    private:
+
+    const SnapshotHeader* m_header=nullptr;
+    const BodyRecord* m_bodies=nullptr;
+    const Vec2* m_vertices=nullptr;
+    const Vec2* m_transformed=nullptr;
+    const EdgeShape* m_edges=nullptr;
+    const uint32_t* m_children=nullptr;
+    const uint32_t* m_touching=nullptr;
+
+};
+
+} // namespace snapshot
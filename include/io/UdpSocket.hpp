@@ -0,0 +1,59 @@
+// UdpSocket.hpp
+
+// ---
+// Minimal non-blocking IPv4 UDP socket ( POSIX ), the transport under io/Replication.hpp.
+
+// Ownership & Lifetime:
+// - UdpSocket owns its descriptor and closes it on destruction. Move-only.
+
+// Error Handling:
+// - open() and resolve() return false on failure. send() returns false if the datagram was not queued,
+//   receive() returns -1 when nothing is waiting ( or on error ). Neither ever blocks.
+// ---
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+constexpr uint32_t kLoopbackAddress=0x7F000001; // 127.0.0.1, host byte order
+constexpr uint32_t kAnyAddress=0; // Every interface
+
+struct Endpoint{
+    uint32_t address{0}; // IPv4, host byte order
+    uint16_t port{0};
+
+    bool operator ==(const Endpoint& o) const { return address==o.address && port==o.port; }
+    bool operator !=(const Endpoint& o) const { return !(*this==o); }
+    bool operator <(const Endpoint& o) const { return address<o.address || (address==o.address && port<o.port); }
+};
+
+// Dotted quad or "localhost"
+bool resolve(const std::string& host, uint16_t port, Endpoint& out);
+
+class UdpSocket{
+
+    public:
+
+    UdpSocket()=default;
+    ~UdpSocket();
+    UdpSocket(UdpSocket&& other) noexcept;
+    UdpSocket& operator=(UdpSocket&& other) noexcept;
+    UdpSocket(const UdpSocket&)=delete;
+    UdpSocket& operator=(const UdpSocket&)=delete;
+
+    // 0 picks an ephemeral port, bufferBytes > 0 sets both socket buffers. Binds to loopback unless given another
+    // interface address ( host byte order, kAnyAddress for all of them ).
+    bool open(uint16_t port=0, size_t bufferBytes=0, uint32_t address=kLoopbackAddress);
+    void close();
+    bool isOpen() const { return m_fd>=0; }
+    uint16_t localPort() const;
+
+    bool send(const Endpoint& to, const void* data, size_t size);
+    int receive(void* data, size_t capacity, Endpoint& from);
+
+    private:
+
+    int m_fd=-1;
+
+};
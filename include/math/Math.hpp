@@ -7,41 +7,44 @@
 
 namespace vecMath{ // Just to avoid potential conflict issues 
 
-    inline float pi=3.141592653589793;
+    inline Real pi=3.141592653589793;
 
-    inline float lengthSquared(const Vec2& a){
+    // The vector helpers are templated on the scalar like Vec2T, sqrt/abs resolve through argument dependent lookup.
+
+    template <typename T> inline T lengthSquared(const Vec2T<T>& a){
         return (a.x*a.x + a.y*a.y);
     }
-    inline float length(const Vec2& a){ // Returns the magnitude of a vector 
-        return std::sqrt(a.x*a.x + a.y*a.y);
+    template <typename T> inline T length(const Vec2T<T>& a){ // Returns the magnitude of a vector 
+        using std::sqrt;
+        return sqrt(a.x*a.x + a.y*a.y);
     }
 
-    inline float distanceSquared(const Vec2& a,const Vec2& b){
-        float xDis=std::abs(a.x-b.x);
-        float yDis=std::abs(a.y-b.y);
+    template <typename T> inline T distanceSquared(const Vec2T<T>& a,const Vec2T<T>& b){
+        using std::abs;
+        T xDis=abs(a.x-b.x);
+        T yDis=abs(a.y-b.y);
         return (xDis*xDis + yDis*yDis);
     }
 
-    inline float distance(const Vec2& a, const Vec2& b){ // Returns the distance between two vectors 
-        float xDis=std::abs(a.x-b.x);
-        float yDis=std::abs(a.y-b.y);
-        return std::sqrt(xDis*xDis + yDis*yDis);
+    template <typename T> inline T distance(const Vec2T<T>& a, const Vec2T<T>& b){ // Returns the distance between two vectors 
+        using std::sqrt;
+        return sqrt(distanceSquared(a,b));
     }
 
-    inline float dot(const Vec2& a,const Vec2& b) { // Dot product of two vectors ( Magnitude of a component in direction of vector B )
+    template <typename T> inline T dot(const Vec2T<T>& a,const Vec2T<T>& b) { // Dot product of two vectors ( Magnitude of a component in direction of vector B )
         return (a.x*b.x)+(a.y*b.y);
     }
 
-    inline float cross(const Vec2& a, const Vec2& b) { // Cross product of two vectors ( Perpendicular vector to both a and b )
+    template <typename T> inline T cross(const Vec2T<T>& a, const Vec2T<T>& b) { // Cross product of two vectors ( Perpendicular vector to both a and b )
         //  Returns solely the Z component, as cross priduct is scalar in 2 dimensions
         return (a.x*b.y)-(a.y*b.x);
     }
 
-    inline Vec2 floatCross(float s, const Vec2& v) {
-        return Vec2(-s * v.y, s * v.x);
+    template <typename T> inline Vec2T<T> floatCross(T s, const Vec2T<T>& v) {
+        return Vec2T<T>(-s * v.y, s * v.x);
     }
 
-    inline bool floatCloselyEqual(float a,float b){
+    inline bool floatCloselyEqual(Real a,Real b){
         return std::abs(a-b) < (1e-3);  // Half mm precision 
     }
 
@@ -49,23 +52,23 @@ namespace vecMath{ // Just to avoid potential conflict issues
         return (floatCloselyEqual(a.x,b.x) && floatCloselyEqual(a.y,b.y));
     }
 
-    inline float pointSegmentDistance(const Vec2& a,const Vec2& b,const Vec2& p,Vec2& contactValue){
+    template <typename T> inline T pointSegmentDistance(const Vec2T<T>& a,const Vec2T<T>& b,const Vec2T<T>& p,Vec2T<T>& contactValue){
 
-        Vec2 ab = (b - a); // segment AB
-        Vec2 ap = (p - a); // from A to P 
+        Vec2T<T> ab = (b - a); // segment AB
+        Vec2T<T> ap = (p - a); // from A to P 
 
-        float abLengthSquared = lengthSquared(ab);
-        if (abLengthSquared <= 0.0f) {
+        T abLengthSquared = lengthSquared(ab);
+        if (abLengthSquared <= T(0)) {
             contactValue = a;
             return distanceSquared(p, a);
         }
 
-        float t = dot(ap, ab) / abLengthSquared;
+        T t = dot(ap, ab) / abLengthSquared;
 
-        Vec2 contact;
-        if (t <= 0.0f){
+        Vec2T<T> contact;
+        if (t <= T(0)){
             contact = a;
-        } else if (t >= 1.0f){
+        } else if (t >= T(1)){
             contact = b;
         } else { 
             contact = a + ab * t;
@@ -9,10 +9,12 @@ struct WorldStats {
     uint64_t broadChecks=0;
     uint64_t narrowChecks=0;
     uint64_t contactsResolved=0;
+    uint64_t ccdHits=0; // Bullet sweeps that were clamped at a time of impact
+    uint64_t childChecks=0; // Compound child pairs that survived the mid-phase and ran SAT
 
     void resetStats(){
         steps=0;
-        bodyUpdates=0; broadChecks=0; narrowChecks=0;contactsResolved=0;
+        bodyUpdates=0; broadChecks=0; narrowChecks=0;contactsResolved=0;ccdHits=0;childChecks=0;
     }
 
 };
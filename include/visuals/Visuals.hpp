@@ -40,6 +40,9 @@ public:
     // Does not modify physics state.
     void drawRigidBody(const RigidBody& body);
 
+    // Draws every static edge as a line segment in one call
+    void drawEdges(const EdgeShape* edges, size_t count);
+
     // Runs the render loop
     // Blocks until the window closes
     void renderLoop();
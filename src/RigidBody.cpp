@@ -3,15 +3,17 @@
 
 #include "core/RigidBody.hpp"
 #include "core/Vector2.hpp"
+#include <algorithm>
+#include <limits>
 
-void setBoxVertices(RigidBody& body, float width, float height){
+void setBoxVertices(RigidBody& body, Real width, Real height){
 
     // Sets local-space vertices for an axis-aligned box (centered at COM).
     // Rebuilds transformedVertices immediately using the body's current position/rotation.
     // Effects: overwrites body.vertices and body.transformedVertices.
 
-    float hw = width  * 0.5f;
-    float hh = height * 0.5f;
+    Real hw = width  * 0.5f;
+    Real hh = height * 0.5f;
 
     // Local-space vertices ccw
     body.vertices.clear();
@@ -26,8 +28,8 @@ void setBoxVertices(RigidBody& body, float width, float height){
     body.transformedVertices.clear();
     body.transformedVertices.reserve(4);
 
-    float c = std::cos(body.rotation);
-    float s = std::sin(body.rotation);
+    Real c = std::cos(body.rotation);
+    Real s = std::sin(body.rotation);
 
     for (const Vec2& v : body.vertices){
         Vec2 rotated(
@@ -41,7 +43,7 @@ void setBoxVertices(RigidBody& body, float width, float height){
 }
 
 
-std::vector<Vec2> generateRegularPolygon(int n, float r){
+std::vector<Vec2> generateRegularPolygon(int n, Real r){
         
     // Generates local-space vertices for a regular n-gon of radius r (centered at origin).
     // Returns vertices in CCW order (suitable for SAT / outward normals).
@@ -52,14 +54,14 @@ std::vector<Vec2> generateRegularPolygon(int n, float r){
     verts.reserve(n);
 
     // Angle between consecutive vertices
-    const float dTheta = 2.0f * M_PI / static_cast<float>(n);
+    const Real dTheta = 2.0f * M_PI / static_cast<Real>(n);
     // Rotate so one vertex points up
-    const float startAngle = -M_PI / 2.0f;
+    const Real startAngle = -M_PI / 2.0f;
 
     for (int i = 0; i < n; ++i){ // Iterate through each side, and generate a vertex 
-        float theta = startAngle + i * dTheta;
-        float x = r * std::cos(theta);
-        float y = r * std::sin(theta);
+        Real theta = startAngle + i * dTheta;
+        Real x = r * std::cos(theta);
+        Real y = r * std::sin(theta);
         verts.emplace_back(x, y); // Construct the Vector2 point of this vertex within the verts vector 
     }
 
@@ -67,21 +69,21 @@ std::vector<Vec2> generateRegularPolygon(int n, float r){
 
 }
 
-float computeRegularPolygonInertia(int n, float m, float r){ 
+Real computeRegularPolygonInertia(int n, Real m, Real r){ 
 
     // Computes moment of inertia about the COM for a solid regular n-gon (approx/closed-form).
     // Returns 0 for invalid input or non-dynamic bodies (m <= 0 or n < 3).
     // Units: inertia in (mass * length^2).
 
     if (n < 3 || m <= 0.0f) return 0.0f; // Either an invalid polygon or a static object 
-    n = static_cast<float>(n);
-    float angle = 2.0f * M_PI / n;
-    float I = (m * r * r / 12.0f) * (3.0f + std::cos(angle));
+    n = static_cast<Real>(n);
+    Real angle = 2.0f * M_PI / n;
+    Real I = (m * r * r / 12.0f) * (3.0f + std::cos(angle));
     return I;
 
 }
 
-float computeInverseMass(float mass, bool isStatic){
+Real computeInverseMass(Real mass, bool isStatic){
 
     // ---
     // Computes the inverse mass, used to avoid division by zero 
@@ -95,7 +97,177 @@ float computeInverseMass(float mass, bool isStatic){
 
 }
 
-RigidBody::RigidBody(int n,float r,float m) : sides(n), radius(r), mass(m) {
+void computePolygonMassProperties(const Vec2* v, size_t count, Real& area, Real& unitInertia){
+
+    // Computes the area and the unit-density moment of inertia of a convex polygon about the local origin.
+    // Either winding is accepted. Multiply unitInertia by the density ( mass / area ) for the real inertia.
+
+    area = 0.0f;
+    unitInertia = 0.0f;
+
+    for (size_t i = 0; i < count; ++i){ // Sum over triangles (origin, v[i], v[i+1])
+        const Vec2& a = v[i];
+        const Vec2& b = v[(i + 1) % count];
+        Real cross = a.x * b.y - a.y * b.x;
+        area += 0.5f * cross;
+        unitInertia += cross * (a.x * a.x + a.y * a.y + a.x * b.x + a.y * b.y + b.x * b.x + b.y * b.y) / 12.0f;
+    }
+
+    area = std::abs(area);
+    unitInertia = std::abs(unitInertia);
+
+}
+
+void computePieceMassProperties(const Vec2* v, const uint32_t* pieceCounts, size_t pieceCount, Real& area, Real& unitInertia){
+
+    // Sums computePolygonMassProperties over the convex pieces of a compound shape. Every piece is taken about
+    // the same local origin ( the combined COM ), so inertias add directly.
+
+    area = 0.0f;
+    unitInertia = 0.0f;
+
+    for (size_t p = 0; p < pieceCount; ++p){
+        Real pieceArea, pieceInertia;
+        computePolygonMassProperties(v, pieceCounts[p], pieceArea, pieceInertia);
+        area += pieceArea;
+        unitInertia += pieceInertia;
+        v += pieceCounts[p];
+    }
+
+}
+
+namespace {
+
+struct ChildBounds{
+    Vec2 min, max, centre;
+    uint32_t child;
+};
+
+uint32_t buildChildNodes(std::vector<ChildBounds>& items, std::vector<ChildNode>& nodes, size_t begin, size_t end){
+
+    // Median split along the longer axis of the centres. Compound bodies have few pieces, so this is plenty.
+
+    const uint32_t node = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(ChildNode{});
+
+    Vec2 min = items[begin].min, max = items[begin].max;
+    Vec2 cmin = items[begin].centre, cmax = items[begin].centre;
+    for (size_t i = begin; i < end; ++i){
+        min = Vec2(std::min(min.x, items[i].min.x), std::min(min.y, items[i].min.y));
+        max = Vec2(std::max(max.x, items[i].max.x), std::max(max.y, items[i].max.y));
+        cmin = Vec2(std::min(cmin.x, items[i].centre.x), std::min(cmin.y, items[i].centre.y));
+        cmax = Vec2(std::max(cmax.x, items[i].centre.x), std::max(cmax.y, items[i].centre.y));
+    }
+
+    if (end - begin == 1){
+        nodes[node] = ChildNode{min, max, items[begin].child, 1};
+        return node;
+    }
+
+    const bool alongX = (cmax.x - cmin.x) >= (cmax.y - cmin.y);
+    const size_t mid = begin + (end - begin) / 2;
+    std::nth_element(items.begin() + begin, items.begin() + mid, items.begin() + end,
+        [&](const ChildBounds& a, const ChildBounds& b){
+            return alongX ? a.centre.x < b.centre.x : a.centre.y < b.centre.y;
+        });
+
+    buildChildNodes(items, nodes, begin, mid);
+    const uint32_t right = buildChildNodes(items, nodes, mid, end);
+    nodes[node] = ChildNode{min, max, right, 0};
+    return node;
+
+}
+
+} // namespace
+
+void setChildShapes(RigidBody& body, const uint32_t* pieceCounts, size_t pieceCount){
+
+    // Splits body.vertices into pieceCount convex pieces and builds the local child BVH over them.
+    // A single piece ( or none ) leaves the body a plain convex polygon.
+    // Preconditions: the piece counts sum to body.vertices.size().
+
+    body.children.clear();
+    body.childTree.clear();
+    if (!pieceCounts || pieceCount < 2) return;
+
+    std::vector<ChildBounds> items;
+    items.reserve(pieceCount);
+    body.children.reserve(pieceCount);
+
+    uint32_t first = 0;
+    for (size_t p = 0; p < pieceCount; ++p){
+        body.children.push_back(ChildShape{first, pieceCounts[p]});
+
+        const Real inf = std::numeric_limits<Real>::infinity();
+        ChildBounds b{Vec2(inf, inf), Vec2(-inf, -inf), Vec2(0.0f, 0.0f), static_cast<uint32_t>(p)};
+        for (uint32_t i = first; i < first + pieceCounts[p]; ++i){
+            const Vec2& v = body.vertices[i];
+            b.min = Vec2(std::min(b.min.x, v.x), std::min(b.min.y, v.y));
+            b.max = Vec2(std::max(b.max.x, v.x), std::max(b.max.y, v.y));
+        }
+        b.centre = (b.min + b.max) * 0.5f;
+        items.push_back(b);
+        first += pieceCounts[p];
+    }
+
+    body.childTree.reserve(2 * pieceCount - 1);
+    buildChildNodes(items, body.childTree, 0, items.size());
+    refreshChildBounds(body);
+
+}
+
+void refreshChildBounds(RigidBody& body){
+
+    // Called whenever transformedVertices are rebuilt ( physEng::worldSpace ), so the mid-phase can cull
+    // child pairs on cached boxes. No-op until the world-space vertices exist.
+
+    if (body.transformedVertices.size() != body.vertices.size()) return;
+
+    for (ChildShape& child : body.children){
+        const Vec2* v = body.transformedVertices.data() + child.first;
+        child.min = child.max = v[0];
+        for (uint32_t i = 1; i < child.count; ++i){
+            child.min = Vec2(std::min(child.min.x, v[i].x), std::min(child.min.y, v[i].y));
+            child.max = Vec2(std::max(child.max.x, v[i].x), std::max(child.max.y, v[i].y));
+        }
+    }
+
+}
+
+void setMassProperties(RigidBody& body, Real mass, Real area, Real unitInertia){
+
+    // Sets mass, density and inertia from precomputed polygon properties ( see computePolygonMassProperties ).
+    // Static bodies ( or mass <= 0 ) keep their area but get zero inverse mass and inertia.
+
+    body.area = area;
+    body.mass = mass;
+    body.density = area > 0.0f ? mass / area : 0.0f;
+    body.inertia = (area > 0.0f && mass > 0.0f) ? unitInertia * (mass / area) : 0.0f;
+    body.inverseMass = computeInverseMass(mass, body.isStatic);
+    body.inverseInertia = (body.isStatic || body.inertia <= 0.0f) ? 0.0f : 1.0f / body.inertia;
+
+}
+
+void setMassFromVertices(RigidBody& body, Real mass){
+
+    // Sets mass and the matching moment of inertia for the body's ( convex or compound, COM centred ) vertices.
+
+    Real area = 0.0f, unitInertia = 0.0f;
+    if (!body.isCompound()){
+        computePolygonMassProperties(body.vertices.data(), body.vertices.size(), area, unitInertia);
+    } else {
+        for (const ChildShape& child : body.children){
+            Real pieceArea, pieceInertia;
+            computePolygonMassProperties(body.vertices.data() + child.first, child.count, pieceArea, pieceInertia);
+            area += pieceArea;
+            unitInertia += pieceInertia;
+        }
+    }
+    setMassProperties(body, mass, area, unitInertia);
+
+}
+
+RigidBody::RigidBody(int n,Real r,Real m) : sides(n), radius(r), mass(m) {
 
     // RigidBody constructor
     // Sets inverse mass for impulse math. Static bodies and non-positive masses return 0.
@@ -106,4 +278,20 @@ RigidBody::RigidBody(int n,float r,float m) : sides(n), radius(r), mass(m) {
     inverseInertia=1/inertia;
     inverseMass=computeInverseMass(m,isStatic);
 
-}
\ No newline at end of file
+}
+
+RigidBody::RigidBody(const BodyDef& def, Real area, Real unitInertia) 
+    : shape(def.shape), sides(static_cast<int>(def.vertexCount)), position(def.position), rotation(def.rotation),
+      linearVelocity(def.linearVelocity), angularVelocity(def.angularVelocity), colour(def.colour),
+      staticFriction(def.staticFriction), dynamicFriction(def.dynamicFriction), restitution(def.restitution),
+      isStatic(def.isStatic), isBullet(def.isBullet), isSensor(def.isSensor),
+      categoryBits(def.categoryBits), maskBits(def.maskBits), groupIndex(def.groupIndex), vertices(def.vertices, def.vertices + def.vertexCount), update(true) {
+
+    // Builds a body straight from a BodyDef ( used for in-place construction by World::createBodies ).
+    // transformedVertices are left empty and built by the first step.
+
+    setChildShapes(*this, def.pieceCounts, def.pieceCount);
+    Real m = def.mass > 0.0f ? def.mass : def.density * area;
+    setMassProperties(*this, m, area, unitInertia);
+
+}
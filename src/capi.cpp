@@ -0,0 +1,95 @@
+// capi.cpp
+// C ABI over VecEnv ( see capi/physics_c.h ).
+
+#include "capi/physics_c.h"
+#include "core/VecEnv.hpp"
+#include "io/Scene.hpp"
+#include <cstdio>
+#include <exception>
+#include <memory>
+#include <string>
+
+static_assert(PHYS_OBSERVATION_FIELDS==kObservationFields,"physics_c.h is out of step with ObservationField");
+static_assert(PHYS_ACTION_FIELDS==kActionFields,"physics_c.h is out of step with ActionField");
+
+struct PhysVecEnv{
+    std::shared_ptr<const World> prototype; // The loaded scene, copied into a world on every reset
+    std::unique_ptr<VecEnv> env;
+};
+
+namespace {
+
+void setError(char* error,size_t size,const std::string& message){
+    if (error && size>0) std::snprintf(error,size,"%s",message.c_str());
+}
+
+} // namespace
+
+extern "C" {
+
+// Exceptions ( std::bad_alloc, std::system_error from the worker threads ) must not cross the ABI, every
+// entry point that can raise one catches it here.
+
+PhysVecEnv* phys_vecenv_create(const PhysVecEnvDesc* desc, char* error, size_t error_size){
+
+    if (!desc || !desc->scene_path || desc->worlds==0 || desc->max_bodies==0 || !(desc->dt>0.0f) || desc->substeps<1){
+        setError(error,error_size,"invalid PhysVecEnvDesc");
+        return nullptr;
+    }
+
+    try {
+        auto prototype=std::make_shared<World>();
+        std::string message;
+        if (!scene::loadScene(desc->scene_path,*prototype,&message)){
+            setError(error,error_size,message);
+            return nullptr;
+        }
+
+        VecEnvConfig config;
+        config.worlds=desc->worlds;
+        config.threads=desc->threads;
+        config.maxBodies=desc->max_bodies;
+        config.dt=static_cast<Real>(desc->dt);
+        config.substeps=desc->substeps;
+
+        auto handle=std::make_unique<PhysVecEnv>();
+        handle->prototype=prototype;
+        const World* source=prototype.get();
+        handle->env=std::make_unique<VecEnv>(config,[source](size_t,World& world){ world=*source; });
+        return handle.release();
+    } catch (const std::exception& e){
+        setError(error,error_size,e.what());
+    } catch (...){
+        setError(error,error_size,"unknown error");
+    }
+    return nullptr;
+
+}
+
+void phys_vecenv_destroy(PhysVecEnv* env){ delete env; }
+
+size_t phys_vecenv_observation_size(const PhysVecEnv* env){ return env->env->observationSize(); }
+size_t phys_vecenv_action_size(const PhysVecEnv* env){ return env->env->actionSize(); }
+float* phys_vecenv_observations(PhysVecEnv* env){ return env->env->observations(); }
+
+int phys_vecenv_reset(PhysVecEnv* env){
+    try { env->env->reset(); } catch (...) { return -1; }
+    return 0;
+}
+
+int phys_vecenv_reset_worlds(PhysVecEnv* env, const uint32_t* worlds, size_t count){
+    try { env->env->reset(worlds,count); } catch (...) { return -1; }
+    return 0;
+}
+
+int phys_vecenv_step(PhysVecEnv* env, const float* actions, float* observations){
+    try { env->env->step(actions,observations); } catch (...) { return -1; }
+    return 0;
+}
+
+int phys_vecenv_observe(PhysVecEnv* env, float* observations){
+    try { env->env->observe(observations); } catch (...) { return -1; }
+    return 0;
+}
+
+} // extern "C"
@@ -7,6 +7,7 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 // -- Contact Point Detection
 
@@ -18,37 +19,34 @@ struct contactResult{
 
 struct contactCandidate{
     Vec2  point;
-    float distSq;
+    Real distSq;
 };
 
-contactResult getContactPoints(const RigidBody& A, const RigidBody& B) {
+contactResult getContactPoints(VertexSpan A, VertexSpan B) {
 
-    // Computes up to two contact points between two colliding convex polygons
+    // Computes up to two contact points between two colliding convex polygons ( world-space vertices )
     // using point-to-edge distance candidates.
-    // Preconditions: A/B transformedVertices are up-to-date and non-empty.
+    // Preconditions: A/B are non-empty.
     // Returns contactCount in [0, 2].
-    // Does not take ownership of A/B.
 
-    if (A.transformedVertices.empty() || B.transformedVertices.empty()) { // Start off with a sanity check of precondition
+    if (A.empty() || B.empty()) { // Start off with a sanity check of precondition
         return { Vec2(0,0), Vec2(0,0), 0 };
     }
 
     std::vector<contactCandidate> candidates;
     candidates.reserve(
-        A.transformedVertices.size() * B.transformedVertices.size() * 2
+        A.size() * B.size() * 2
     ); 
 
     // Helper function that pushes candidates for 'points of P to edges of Q'
-    auto gatherCandidates = [&](const RigidBody& P, const RigidBody& Q) {
-        const auto& vertsP = P.transformedVertices;
-        const auto& vertsQ = Q.transformedVertices;
+    auto gatherCandidates = [&](VertexSpan vertsP, VertexSpan vertsQ) {
 
         for (const Vec2& vP : vertsP) {
             for (size_t i = 0; i < vertsQ.size(); ++i) {
                 const Vec2& q1 = vertsQ[i];
                 const Vec2& q2 = vertsQ[(i + 1) % vertsQ.size()];
                 Vec2 contact;
-                float d2 = vecMath::pointSegmentDistance(q1, q2, vP, contact);
+                Real d2 = vecMath::pointSegmentDistance(q1, q2, vP, contact);
                 candidates.push_back({ contact, d2 });
             }
         }
@@ -63,16 +61,16 @@ contactResult getContactPoints(const RigidBody& A, const RigidBody& B) {
     }
 
     // Find the global minimum distance 
-    float minDistSq = candidates[0].distSq;
+    Real minDistSq = candidates[0].distSq;
     for (const auto& c : candidates) {
         if (c.distSq < minDistSq) {
             minDistSq = c.distSq;
         }
     }
     
-    const float eps = 0.0001f; // The tolerance value, determines the 'close enough' threshold
+    const Real eps = 0.0001f; // The tolerance value, determines the 'close enough' threshold
     // Two vertices may be close but not exactly touching, if they're close enough we should still register it as a contact point
-    float threshold = minDistSq + eps; // This defines how close 'close enough' is 
+    Real threshold = minDistSq + eps; // This defines how close 'close enough' is 
 
     Vec2 contact1{};
     Vec2 contact2{};
@@ -102,17 +100,17 @@ contactResult getContactPoints(const RigidBody& A, const RigidBody& B) {
 
 // Helper functions for SATCollision
 
-void projectAxis(const std::vector<Vec2>& vertices,const Vec2& normalAxis,float& max,float& min){ 
+void projectAxis(VertexSpan vertices,const Vec2& normalAxis,Real& max,Real& min){ 
     
    // Projects polygon vertices onto an axis and outputs the [min, max] interval.
    // min and max are used to discern if two projections overlap or not, used to discern seperating axis. 
    // Preconditions: vertices is non-empty.
 
-    float projection = vecMath::dot(vertices[0], normalAxis);
+    Real projection = vecMath::dot(vertices[0], normalAxis);
     min = max = projection; // Establish a baseline 
     for (size_t i=1;i<vertices.size();++i){ // Starting from one as we already established vertices[0] 
         Vec2 vertice=vertices[i];
-        float projection=vecMath::dot(vertice,normalAxis);
+        Real projection=vecMath::dot(vertice,normalAxis);
         if (projection<min){ min=projection; }
         if (projection>max) { max=projection; }
     }
@@ -120,13 +118,9 @@ void projectAxis(const std::vector<Vec2>& vertices,const Vec2& normalAxis,float&
 }
 
 
-bool SATLoop(const RigidBody& A,const RigidBody& B,float& penetration,Vec2& normal){
+bool SATLoop(VertexSpan verticesA,VertexSpan verticesB,Real& penetration,Vec2& normal){
 
     // Runs the SAT loop, checking the normal of each polygon face and then projecting to attempt to find a 'seperating axis'.
-    // Does not take ownership of A or B.
-  
-    const auto& verticesA = A.transformedVertices;
-    const auto& verticesB = B.transformedVertices;
 
     for (size_t i=0;i<verticesA.size();i++){   // Loops through a polygon's vertices to evaluate each normal axis
        
@@ -136,8 +130,8 @@ bool SATLoop(const RigidBody& A,const RigidBody& B,float& penetration,Vec2& norm
         Vec2 normalAxis=Vec2(-edge.y,edge.x); // The axis to test for seperation, in Clockwise winding order 
         normalAxis=normalAxis.normalise();
 
-        float maxA,minA;
-        float maxB,minB;
+        Real maxA,minA;
+        Real maxB,minB;
 
         // Project vertices onto normal axis
         projectAxis(verticesA,normalAxis,maxA,minA);
@@ -148,7 +142,7 @@ bool SATLoop(const RigidBody& A,const RigidBody& B,float& penetration,Vec2& norm
         }
 
         // At this point, we know there is overlap ( i.e. for this particlar normal there is no seperation ) 
-        float axisDepth=std::min(maxA-minB,maxB-minA);
+        Real axisDepth=std::min(maxA-minB,maxB-minA);
         if (axisDepth<penetration){
             penetration=axisDepth;
             normal=normalAxis;
@@ -160,41 +154,265 @@ bool SATLoop(const RigidBody& A,const RigidBody& B,float& penetration,Vec2& norm
 
 }
 
-// Main SAT function, utilising helpers. Attempts to find a seperating axis to discern if two objects are touching or not.
-Manifold SATCollision(RigidBody& RigidBodyA,RigidBody& RigidBodyB) { 
-    
-    // Separating Axis Theorem (SAT) collision test for two convex polygons.
-    // Returns a Manifold with normal (A->B), penetration depth, and up to two contact points.
-    // Preconditions: transformedVertices for both bodies are up-to-date.
+Real SATSeparation(VertexSpan A,VertexSpan B,Vec2& normal){
+
+    // Largest gap between the two polygons' projections over both polygons' edge normals.
+    // For separated convex polygons this is their distance along the best separating axis.
+    // normal is set to that axis, pointing from A to B.
+
+    Real best=-std::numeric_limits<Real>::infinity();
+    auto testAxes=[&](VertexSpan verts){
+        for (size_t i=0;i<verts.size();++i){
+            Vec2 edge=verts[(i+1)%verts.size()]-verts[i];
+            Vec2 axis=Vec2(-edge.y,edge.x).normalise();
+
+            Real maxA,minA,maxB,minB;
+            projectAxis(A,axis,maxA,minA);
+            projectAxis(B,axis,maxB,minB);
+
+            if (minB-maxA>best){ best=minB-maxA; normal=axis; } // B ahead of A
+            if (minA-maxB>best){ best=minA-maxB; normal=axis*-1; } // B behind A
+        }
+    };
+    testAxes(A);
+    testAxes(B);
+    return best;
+
+}
+
+bool polygonsOverlap(VertexSpan A,VertexSpan B){
+
+    // Early-out SAT: any edge normal of either polygon with a gap between the projections separates them.
+
+    if (A.empty() || B.empty()) return false;
+    auto separatedBy=[&](VertexSpan P){
+        for (size_t i=0;i<P.size();++i){
+            Vec2 edge=P[(i+1)%P.size()]-P[i];
+            Vec2 axis(-edge.y,edge.x); // No need to normalise for a sign test
+            Real maxA,minA,maxB,minB;
+            projectAxis(A,axis,maxA,minA);
+            projectAxis(B,axis,maxB,minB);
+            if (maxA<minB || maxB<minA) return true;
+        }
+        return false;
+    };
+    return !separatedBy(A) && !separatedBy(B);
+
+}
+
+bool collidePolygons(VertexSpan A,const Vec2& centreA,VertexSpan B,const Vec2& centreB,Real speculativeMargin,PolygonContact& out){
 
-    float penetration = std::numeric_limits<float>::infinity(); // Will yield as the smallest penetration
+    // Separating Axis Theorem (SAT) collision test for two convex polygons ( world-space vertices ).
+    // Fills out with the normal (A->B), penetration depth, and up to two contact points.
+    // The centres only orient the normal, any interior point works.
+
+    Real penetration = std::numeric_limits<Real>::infinity(); // Will yield as the smallest penetration
     Vec2 normal{0.0f,0.0f}; // Will yield as the normal for the smallest penetration
     bool inCollision{true}; // Whether the two objects are in collision or not
 
     // Evaluate all edge-normals of the polygons  
-    if (!SATLoop(RigidBodyA,RigidBodyB,penetration,normal)) inCollision=false;
-    if (!SATLoop(RigidBodyB,RigidBodyA,penetration,normal)) inCollision=false;
+    if (!SATLoop(A,B,penetration,normal)) inCollision=false;
+    if (!SATLoop(B,A,penetration,normal)) inCollision=false;
     
     contactResult contactData;
 
     if (inCollision){
-        if (vecMath::dot(normal, RigidBodyB.position - RigidBodyA.position) < 0.0f) {
+        if (vecMath::dot(normal, centreB - centreA) < 0.0f) {
             normal = normal*-1;  // Ensure the normal always points from a to b to avoid merging objects 
         }
-       contactData=getContactPoints(RigidBodyA,RigidBodyB); // If the object is in collision start to register the contact points 
+       contactData=getContactPoints(A,B); // If the object is in collision start to register the contact points 
+    } else if (speculativeMargin>0.0f){
+        // Not touching yet, but close enough to meet this step: report a speculative contact
+        Real gap=SATSeparation(A,B,normal);
+        if (gap<=speculativeMargin){
+            inCollision=true;
+            penetration=-gap;
+            contactData=getContactPoints(A,B); // Closest features between the two
+        }
     }
 
-    Manifold manifold{ // Build a manifold to describe the outcome of the collision
-        RigidBodyA,
-        RigidBodyB,
-        normal,
-        contactData.contact1,
-        contactData.contact2,
-        contactData.contactCount,
-        penetration,
-        inCollision
-    };
+    if (!inCollision) return false;
+    out.normal=normal;
+    out.contact1=contactData.contact1;
+    out.contact2=contactData.contact2;
+    out.contactCount=contactData.contactCount;
+    out.penetration=penetration;
+    return true;
+
+}
+
+// Main SAT function. Attempts to find a seperating axis to discern if two objects are touching or not.
+Manifold SATCollision(RigidBody& RigidBodyA,RigidBody& RigidBodyB,Real speculativeMargin) { 
+    
+    // Whole-body SAT for two convex ( single piece ) bodies, see collidePolygons().
+    // Preconditions: transformedVertices for both bodies are up-to-date.
 
+    Manifold manifold{RigidBodyA,RigidBodyB}; // Build a manifold to describe the outcome of the collision
+    PolygonContact contact;
+    if (collidePolygons(RigidBodyA.transformedVertices,RigidBodyA.position,RigidBodyB.transformedVertices,RigidBodyB.position,
+                        speculativeMargin,contact)){
+        manifold.normal=contact.normal;
+        manifold.contact1=contact.contact1;
+        manifold.contact2=contact.contact2;
+        manifold.contactCount=contact.contactCount;
+        manifold.penetration=contact.penetration;
+        manifold.inCollision=true;
+    }
     return manifold;
 
 }  
+
+
+// -- Ray casting
+
+bool rayPolygon(const Vec2& origin,const Vec2& delta,VertexSpan vertices,Real maxFraction,Real& fraction,Vec2& normal){
+
+    // Cyrus-Beck clipping of the segment against every edge's half-plane.
+    // lower/upper track the parametric interval still inside the polygon.
+
+    const size_t n=vertices.size();
+    if (n<3) return false;
+
+    // Winding decides which perpendicular of an edge points outwards
+    Real signedArea=0.0f;
+    for (size_t i=0;i<n;++i){
+        signedArea+=vecMath::cross(vertices[i],vertices[(i+1)%n]);
+    }
+    const Real outward=signedArea>=0.0f ? 1.0f : -1.0f;
+
+    Real lower=0.0f;
+    Real upper=maxFraction;
+    int entryEdge=-1;
+
+    for (size_t i=0;i<n;++i){
+        const Vec2& a=vertices[i];
+        const Vec2& b=vertices[(i+1)%n];
+        Vec2 edge=b-a;
+        Vec2 edgeNormal=Vec2(edge.y,-edge.x)*outward;
+
+        Real numerator=vecMath::dot(edgeNormal,a-origin);
+        Real denominator=vecMath::dot(edgeNormal,delta);
+
+        if (denominator==0.0f){
+            if (numerator<0.0f) return false; // Parallel and outside this edge
+            continue;
+        }
+
+        Real t=numerator/denominator;
+        if (denominator<0.0f){ // Entering this half-plane
+            if (t>lower){ lower=t; entryEdge=static_cast<int>(i); }
+        } else { // Leaving it
+            if (t<upper) upper=t;
+        }
+        if (upper<lower) return false;
+    }
+
+    if (entryEdge<0) return false; // Origin is inside the polygon
+
+    const Vec2& a=vertices[entryEdge];
+    const Vec2& b=vertices[(entryEdge+1)%n];
+    Vec2 edge=b-a;
+    normal=(Vec2(edge.y,-edge.x)*outward).normalise();
+    fraction=lower;
+    return true;
+
+}
+
+bool pointInPolygon(const Vec2& p,VertexSpan vertices){
+
+    // p is inside a convex polygon when it is on the same side of every edge.
+
+    const size_t n=vertices.size();
+    if (n<3) return false;
+
+    bool hasPositive=false, hasNegative=false;
+    for (size_t i=0;i<n;++i){
+        Real side=vecMath::cross(vertices[(i+1)%n]-vertices[i],p-vertices[i]);
+        if (side>0.0f) hasPositive=true;
+        if (side<0.0f) hasNegative=true;
+        if (hasPositive && hasNegative) return false;
+    }
+    return true;
+
+}
+
+// -- Swept SAT ( time of impact )
+
+bool sweepPolygons(VertexSpan A,const Vec2& delta,VertexSpan B,Real maxFraction,
+                   Real& fraction,Vec2& normal,Vec2& point){
+
+    // For translating convex polygons, each separating axis gives an interval of time in which the
+    // projections overlap. The polygons touch during the intersection of all those intervals, so the
+    // time of impact is the latest entry, as long as it comes before the earliest exit.
+
+    if (A.size()<2 || B.size()<2) return false;
+
+    Real latestEntry=-std::numeric_limits<Real>::infinity();
+    Real earliestExit=std::numeric_limits<Real>::infinity();
+    Vec2 entryAxis{0.0f,0.0f};
+    bool entryOnB=false; // Whether the entry axis is one of B's faces
+
+    auto testAxes=[&](VertexSpan poly,bool isB){
+        for (size_t i=0;i<poly.size();++i){
+            Vec2 edge=poly[(i+1)%poly.size()]-poly[i];
+            Vec2 axis=Vec2(-edge.y,edge.x).normalise();
+            if (axis.lengthSquared()==0.0f) continue;
+
+            Real maxA,minA,maxB,minB;
+            projectAxis(A,axis,maxA,minA);
+            projectAxis(B,axis,maxB,minB);
+            Real speed=vecMath::dot(delta,axis);
+
+            Real enter,exit;
+            if (maxA<minB){ // A is behind B on this axis
+                if (speed<=0.0f) return false;
+                enter=(minB-maxA)/speed;
+                exit=(maxB-minA)/speed;
+            } else if (maxB<minA){ // A is ahead of B
+                if (speed>=0.0f) return false;
+                enter=(maxB-minA)/speed;
+                exit=(minB-maxA)/speed;
+            } else { // Already overlapping on this axis
+                enter=-std::numeric_limits<Real>::infinity();
+                if (speed>0.0f) exit=(maxB-minA)/speed;
+                else if (speed<0.0f) exit=(minB-maxA)/speed;
+                else exit=std::numeric_limits<Real>::infinity();
+            }
+
+            if (enter>latestEntry){
+                latestEntry=enter;
+                entryAxis=axis;
+                entryOnB=isB;
+            }
+            earliestExit=std::min(earliestExit,exit);
+            if (latestEntry>earliestExit || latestEntry>maxFraction) return false;
+        }
+        return true;
+    };
+
+    if (!testAxes(A,false) || !testAxes(B,true)) return false;
+
+    if (latestEntry<0.0f){ // Overlapping before moving at all
+        fraction=0.0f;
+        normal=Vec2(0.0f,0.0f);
+        point=A[0];
+        return true;
+    }
+
+    fraction=latestEntry;
+    normal=vecMath::dot(entryAxis,delta)>0.0f ? entryAxis*-1.0f : entryAxis; // Faces back along the motion
+
+    // The touching feature is the support point of whichever polygon did not supply the axis
+    Vec2 offset=delta*fraction;
+    if (entryOnB){
+        const Vec2* support=&A[0];
+        for (const Vec2& v : A) if (vecMath::dot(v,normal)<vecMath::dot(*support,normal)) support=&v;
+        point=*support+offset;
+    } else {
+        const Vec2* support=&B[0];
+        for (const Vec2& v : B) if (vecMath::dot(v,normal)>vecMath::dot(*support,normal)) support=&v;
+        point=*support;
+    }
+    return true;
+
+}
@@ -0,0 +1,220 @@
+// compound.cpp
+// Convex decomposition of concave outlines and multi-shape composition for compound bodies ( see collision/Compound.hpp ).
+
+#include "collision/Compound.hpp"
+#include "math/Math.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr Real kEpsilon=1e-6f;
+
+Real turn(const Vec2& a,const Vec2& b,const Vec2& c){ return vecMath::cross(b-a,c-b); } // > 0 for a left ( CCW ) turn
+
+bool inTriangle(const Vec2& p,const Vec2& a,const Vec2& b,const Vec2& c){ // Inclusive, for a CCW triangle
+    return vecMath::cross(b-a,p-a)>=-kEpsilon && vecMath::cross(c-b,p-b)>=-kEpsilon && vecMath::cross(a-c,p-c)>=-kEpsilon;
+}
+
+bool triangulate(const std::vector<Vec2>& points,std::vector<std::vector<int>>& triangles){
+
+    // Ear clipping over a CCW simple polygon. An ear is a convex corner whose triangle holds no other
+    // remaining point. Fails when no ear exists, which only happens for self intersecting outlines.
+
+    std::vector<int> remaining(points.size());
+    for (size_t i=0;i<points.size();++i) remaining[i]=static_cast<int>(i);
+
+    while (remaining.size()>3){
+        const size_t n=remaining.size();
+        bool clipped=false;
+        for (size_t i=0;i<n && !clipped;++i){
+            const int prev=remaining[(i+n-1)%n];
+            const int cur=remaining[i];
+            const int next=remaining[(i+1)%n];
+            const Vec2& a=points[prev];
+            const Vec2& b=points[cur];
+            const Vec2& c=points[next];
+            if (turn(a,b,c)<=kEpsilon) continue; // Reflex or flat corner
+
+            bool empty=true;
+            for (int other : remaining){
+                if (other==prev || other==cur || other==next) continue;
+                if (inTriangle(points[other],a,b,c)) { empty=false; break; }
+            }
+            if (!empty) continue;
+
+            triangles.push_back({prev,cur,next});
+            remaining.erase(remaining.begin()+i);
+            clipped=true;
+        }
+        if (!clipped) return false;
+    }
+
+    triangles.push_back(remaining);
+    return true;
+
+}
+
+bool tryMerge(const std::vector<Vec2>& points,std::vector<int>& p,const std::vector<int>& q){
+
+    // Hertel-Mehlhorn step: if p and q share an edge and removing it keeps the union convex, p becomes the union.
+    // Both are CCW, so the shared edge runs a -> b in p and b -> a in q.
+
+    const size_t np=p.size(), nq=q.size();
+    for (size_t i=0;i<np;++i){
+        const int a=p[i], b=p[(i+1)%np];
+        for (size_t j=0;j<nq;++j){
+            if (q[j]!=b || q[(j+1)%nq]!=a) continue;
+
+            // Union: p from b round to a, then q's points strictly between a and b
+            std::vector<int> merged;
+            merged.reserve(np+nq-2);
+            for (size_t k=0;k<np;++k) merged.push_back(p[(i+1+k)%np]);
+            for (size_t k=2;k<nq;++k) merged.push_back(q[(j+k)%nq]);
+
+            // Only the corners at a and b changed
+            const size_t n=merged.size();
+            for (size_t k=0;k<n;++k){
+                if (merged[k]!=a && merged[k]!=b) continue;
+                if (turn(points[merged[(k+n-1)%n]],points[merged[k]],points[merged[(k+1)%n]])<-kEpsilon) return false;
+            }
+            p.swap(merged);
+            return true;
+        }
+    }
+    return false;
+
+}
+
+} // namespace
+
+bool decomposeConvex(const Vec2* outline, size_t count, std::vector<Vec2>& vertices, std::vector<uint32_t>& pieceCounts,
+                     Vec2* centre){
+
+    // Cleans the outline ( repeated and collinear points ), makes it CCW, triangulates it by ear clipping,
+    // then greedily merges neighbouring pieces while they stay convex. Hertel-Mehlhorn guarantees at most
+    // four times the optimal piece count, and usually does much better.
+
+    if (!outline || count<3) return false;
+
+    std::vector<Vec2> points;
+    points.reserve(count);
+    for (size_t i=0;i<count;++i){
+        if (points.empty() || (outline[i]-points.back()).length()>kEpsilon) points.push_back(outline[i]);
+    }
+    while (points.size()>1 && (points.front()-points.back()).length()<=kEpsilon) points.pop_back();
+
+    for (size_t i=0;i<points.size() && points.size()>=3;){ // Drop flat corners
+        const size_t n=points.size();
+        if (std::abs(turn(points[(i+n-1)%n],points[i],points[(i+1)%n]))<=kEpsilon) points.erase(points.begin()+i);
+        else ++i;
+    }
+    if (points.size()<3) return false;
+
+    // Signed area and centre of mass of the outline
+    Real area=0.0f;
+    Vec2 centroid(0.0f,0.0f);
+    for (size_t i=0;i<points.size();++i){
+        const Vec2& a=points[i];
+        const Vec2& b=points[(i+1)%points.size()];
+        const Real cross=vecMath::cross(a,b);
+        area+=0.5f*cross;
+        centroid+=(a+b)*cross;
+    }
+    if (std::abs(area)<=kEpsilon) return false;
+    centroid=centroid*(1.0f/(6.0f*area));
+    if (area<0.0f) std::reverse(points.begin(),points.end());
+
+    std::vector<std::vector<int>> pieces;
+    if (!triangulate(points,pieces)) return false;
+
+    for (bool merged=true;merged;){
+        merged=false;
+        for (size_t i=0;i<pieces.size() && !merged;++i){
+            for (size_t j=i+1;j<pieces.size();++j){
+                if (tryMerge(points,pieces[i],pieces[j])){
+                    pieces.erase(pieces.begin()+j);
+                    merged=true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const std::vector<int>& piece : pieces){
+        for (int index : piece) vertices.push_back(points[index]-centroid);
+        pieceCounts.push_back(static_cast<uint32_t>(piece.size()));
+    }
+    if (centre) *centre=centroid;
+    return true;
+
+}
+
+bool composeShapes(const ShapeDef* shapes, size_t count, std::vector<Vec2>& vertices, std::vector<uint32_t>& pieceCounts,
+                   ComposedMass& mass){
+
+    // Two passes: place every shape and find the density weighted centre of mass, then shift the pieces onto
+    // it and sum each piece's inertia about it. The inertia is returned per unit of mean density, so the
+    // usual setMassProperties() path turns it into the real inertia for whatever total mass is chosen.
+
+    if (!shapes || count==0) return false;
+
+    std::vector<Vec2> placed;
+    std::vector<uint32_t> counts;
+    Real area=0.0f, weightedArea=0.0f;
+    Vec2 weightedCentre(0.0f,0.0f);
+
+    for (size_t s=0;s<count;++s){
+        const ShapeDef& shape=shapes[s];
+        if (!shape.vertices || shape.vertexCount<3) return false;
+
+        const Real c=std::cos(shape.rotation);
+        const Real sn=std::sin(shape.rotation);
+        const size_t first=placed.size();
+        for (size_t i=0;i<shape.vertexCount;++i){
+            const Vec2& v=shape.vertices[i];
+            placed.push_back(shape.offset+Vec2(v.x*c-v.y*sn,v.x*sn+v.y*c));
+        }
+        counts.push_back(static_cast<uint32_t>(shape.vertexCount));
+
+        // Area and centroid of the placed piece
+        Real pieceArea=0.0f;
+        Vec2 centroid(0.0f,0.0f);
+        for (size_t i=0;i<shape.vertexCount;++i){
+            const Vec2& a=placed[first+i];
+            const Vec2& b=placed[first+(i+1)%shape.vertexCount];
+            const Real cross=vecMath::cross(a,b);
+            pieceArea+=0.5f*cross;
+            centroid+=(a+b)*cross;
+        }
+        if (pieceArea==0.0f) return false;
+        centroid=centroid*(1.0f/(6.0f*pieceArea));
+        pieceArea=std::abs(pieceArea);
+
+        area+=pieceArea;
+        weightedArea+=shape.density*pieceArea;
+        weightedCentre+=centroid*(shape.density*pieceArea);
+    }
+    if (weightedArea<=0.0f) return false;
+
+    const Vec2 centre=weightedCentre*(1.0f/weightedArea);
+    for (Vec2& v : placed) v-=centre;
+
+    Real weightedInertia=0.0f;
+    const Vec2* piece=placed.data();
+    for (size_t s=0;s<count;++s){
+        Real pieceArea, pieceInertia;
+        computePolygonMassProperties(piece,counts[s],pieceArea,pieceInertia);
+        weightedInertia+=shapes[s].density*pieceInertia;
+        piece+=counts[s];
+    }
+
+    vertices.insert(vertices.end(),placed.begin(),placed.end());
+    pieceCounts.insert(pieceCounts.end(),counts.begin(),counts.end());
+    mass.centre=centre;
+    mass.area=area;
+    mass.weightedArea=weightedArea;
+    mass.unitInertia=weightedInertia*area/weightedArea; // Mean density = weightedArea / area
+    return true;
+
+}
@@ -0,0 +1,141 @@
+// edge.cpp
+// One-sided edge vs convex polygon collision with ghost vertex normal limits.
+
+#include "collision/Edge.hpp"
+#include "math/Math.hpp"
+#include <cmath>
+#include <limits>
+
+namespace {
+
+inline Vec2 leftPerp(const Vec2& v){ return Vec2(-v.y,v.x); }
+
+bool admissible(const EdgeShape& edge,const Vec2& tangent,const Vec2& N){
+
+    // Whether N ( from edge to polygon ) lies in the edge's normal cone.
+    // Leaning towards v1 rotates N counter-clockwise from the face normal, towards v2 clockwise.
+    // At a convex joint the cone reaches the neighbour's normal, at a concave joint the neighbour blocks it.
+
+    const Real tolerance=1e-4f;
+    if (vecMath::dot(N,edge.normal)<0.0f) return false;
+
+    const Real lean=vecMath::dot(N,tangent);
+    if (lean<-tolerance && edge.hasV0){
+        Vec2 previous=edge.v1-edge.v0;
+        if (vecMath::cross(previous,edge.v2-edge.v1)>0.0f) return false; // Concave joint
+        Vec2 n0=leftPerp(previous).normalise();
+        return vecMath::cross(N,n0)>=-tolerance;
+    }
+    if (lean>tolerance && edge.hasV3){
+        Vec2 next=edge.v3-edge.v2;
+        if (vecMath::cross(edge.v2-edge.v1,next)>0.0f) return false;
+        Vec2 n2=leftPerp(next).normalise();
+        return vecMath::cross(n2,N)>=-tolerance;
+    }
+    return true;
+
+}
+
+int clipToSlab(Vec2 a,Vec2 b,const Vec2& origin,const Vec2& axis,Real length,Vec2 out[2]){
+
+    // Clips segment a-b to the slab 0 <= dot(x - origin, axis) <= length. Returns the points kept.
+
+    Real da=vecMath::dot(a-origin,axis);
+    Real db=vecMath::dot(b-origin,axis);
+    if ((da<0.0f && db<0.0f) || (da>length && db>length)) return 0;
+
+    auto lerpAt=[&](Real target){
+        Real t=(target-da)/(db-da);
+        return a+(b-a)*t;
+    };
+    if (da<0.0f) { a=lerpAt(0.0f); } else if (da>length) { a=lerpAt(length); }
+    if (db<0.0f) { b=lerpAt(0.0f); } else if (db>length) { b=lerpAt(length); }
+    out[0]=a;
+    out[1]=b;
+    return 2;
+
+}
+
+} // namespace
+
+bool collideEdgePolygon(const EdgeShape& edge,VertexSpan polygon,const Vec2& centre,Real margin,EdgeContact& out){
+
+    // SAT over the edge normal and the polygon's face normals. The edge face is the reference unless an
+    // admissible polygon face separates noticeably more, the incident feature is then clipped against it.
+
+    const size_t n=polygon.size();
+    if (n<3) return false;
+
+    const Vec2 edgeVec=edge.v2-edge.v1;
+    const Real edgeLength=edgeVec.length();
+    if (edgeLength<=0.0f) return false;
+    const Vec2 tangent=edgeVec*(1.0f/edgeLength);
+
+    if (vecMath::dot(centre-edge.v1,edge.normal)<0.0f) return false; // Behind a one-sided edge
+
+    // Edge face axis
+    Real edgeSeparation=std::numeric_limits<Real>::infinity();
+    for (const Vec2& p : polygon) edgeSeparation=std::min(edgeSeparation,vecMath::dot(p-edge.v1,edge.normal));
+    if (edgeSeparation>margin) return false;
+
+    // Polygon face axes
+    Real polySeparation=-std::numeric_limits<Real>::infinity();
+    int polyFace=-1;
+    Vec2 polyNormal;
+    for (size_t i=0;i<n;++i){
+        const Vec2& a=polygon[i];
+        Vec2 m=leftPerp(polygon[(i+1)%n]-a).normalise();
+        if (vecMath::dot(m,a-centre)<0.0f) m=m*-1; // Outward, whatever the winding
+
+        Real s=std::min(vecMath::dot(edge.v1-a,m),vecMath::dot(edge.v2-a,m));
+        if (s>margin) return false; // Any separating axis means no contact
+        if (s>polySeparation && admissible(edge,tangent,m*-1)){
+            polySeparation=s;
+            polyFace=static_cast<int>(i);
+            polyNormal=m;
+        }
+    }
+
+    const Real relativeTol=0.98f;
+    const Real absoluteTol=0.001f;
+    Vec2 clipped[2];
+    Real minSeparation=std::numeric_limits<Real>::infinity();
+    out.count=0;
+
+    if (polyFace>=0 && polySeparation>relativeTol*edgeSeparation+absoluteTol){
+        // Polygon face is the reference, the edge segment is incident
+        const Vec2& r1=polygon[polyFace];
+        const Vec2 faceVec=polygon[(polyFace+1)%n]-r1;
+        const Real faceLength=faceVec.length();
+        if (clipToSlab(edge.v1,edge.v2,r1,faceVec*(1.0f/faceLength),faceLength,clipped)==0) return false;
+
+        out.normal=polyNormal*-1;
+        for (const Vec2& x : clipped){
+            Real s=vecMath::dot(x-r1,polyNormal);
+            if (s<=margin){ out.points[out.count++]=x; minSeparation=std::min(minSeparation,s); }
+        }
+    } else {
+        // Edge face is the reference, the polygon face most against the edge normal is incident
+        size_t incident=0;
+        Real mostAgainst=std::numeric_limits<Real>::infinity();
+        for (size_t i=0;i<n;++i){
+            Vec2 m=leftPerp(polygon[(i+1)%n]-polygon[i]).normalise();
+            if (vecMath::dot(m,polygon[i]-centre)<0.0f) m=m*-1;
+            Real d=vecMath::dot(m,edge.normal);
+            if (d<mostAgainst){ mostAgainst=d; incident=i; }
+        }
+        if (clipToSlab(polygon[incident],polygon[(incident+1)%n],edge.v1,tangent,edgeLength,clipped)==0) return false;
+
+        out.normal=edge.normal;
+        for (const Vec2& x : clipped){
+            Real s=vecMath::dot(x-edge.v1,edge.normal);
+            if (s<=margin){ out.points[out.count++]=x; minSeparation=std::min(minSeparation,s); }
+        }
+    }
+
+    if (out.count==0) return false;
+    if (out.count==2 && (out.points[0]-out.points[1]).length()<1e-5f) out.count=1; // Collapsed to a point
+    out.penetration=-minSeparation;
+    return true;
+
+}
@@ -0,0 +1,109 @@
+// fixed.cpp
+// Deterministic sqrt and table based sin/cos for the Q16.16 Fixed scalar ( see core/Fixed.hpp ).
+
+#include "core/Fixed.hpp"
+#include <array>
+
+namespace fixedpoint {
+
+namespace {
+
+constexpr int kQuarterSteps=1024; // Table entries per quarter turn
+constexpr int kPhaseBits=24; // A full turn is 2^24 phase units
+constexpr int kSubBits=kPhaseBits-2-10; // Interpolation bits between table entries
+constexpr int64_t kTwoPiQ32=26986075409; // 2 pi in Q32.32, for range reduction
+constexpr int64_t kHalfPiQ30=1686629713; // pi / 2 in Q2.30, for building the table
+
+using SineTable=std::array<int32_t,kQuarterSteps+2>;
+
+SineTable buildTable(){
+
+    // sin over [0, pi/2] by Taylor series in Q2.30 integer arithmetic, so every platform builds the same
+    // table without touching the FPU. The last entry is repeated to keep interpolation in bounds.
+
+    SineTable table{};
+    for (int i=0;i<=kQuarterSteps;++i){
+        const int64_t x=kHalfPiQ30*i/kQuarterSteps;
+        const int64_t x2=(x*x)>>30;
+        int64_t term=x;
+        int64_t sum=x;
+        for (int n=1;term!=0;++n){
+            term=-((term*x2)>>30)/((2*n)*(2*n+1));
+            sum+=term;
+        }
+        table[i]=static_cast<int32_t>((sum+(1<<13))>>14); // Q2.30 -> Q16.16, rounded
+    }
+    table[kQuarterSteps+1]=table[kQuarterSteps];
+    return table;
+
+}
+
+const SineTable& sineTable(){
+    static const SineTable table=buildTable();
+    return table;
+}
+
+int32_t sinPhase(uint32_t phase){
+
+    // phase in [0, 2^24) is one turn. The quarter is mirrored and negated from the first quadrant.
+
+    constexpr uint32_t quarter=1u<<(kPhaseBits-2);
+    phase&=(1u<<kPhaseBits)-1;
+    const uint32_t quadrant=phase>>(kPhaseBits-2);
+    uint32_t u=phase&(quarter-1); // Position within the quarter
+    if (quadrant&1) u=quarter-u;
+
+    const SineTable& table=sineTable();
+    const uint32_t index=u>>kSubBits;
+    const int64_t a=table[index];
+    const int64_t b=table[index+1];
+    const int64_t frac=u&((1u<<kSubBits)-1);
+    const int32_t value=static_cast<int32_t>(a+(((b-a)*frac+(1<<(kSubBits-1)))>>kSubBits));
+    return (quadrant&2) ? -value : value;
+
+}
+
+uint32_t toPhase(Fixed radians){
+
+    // Radians to turns in 2^-24 units. The angle is first reduced modulo 2 pi at 32 fractional bits,
+    // then scaled, negative angles wrap through two's complement.
+
+    const int64_t reduced=(static_cast<int64_t>(radians.raw)*65536)%kTwoPiQ32;
+    return static_cast<uint32_t>(reduced*(int64_t(1)<<kPhaseBits)/kTwoPiQ32);
+
+}
+
+} // namespace
+
+Fixed sqrt(Fixed x){
+
+    // Digit by digit square root of raw << 16, which is the Q16.16 root exactly ( truncated ).
+
+    if (x.raw<=0) return Fixed{};
+
+    uint64_t value=static_cast<uint64_t>(x.raw)<<Fixed::kFractionBits;
+    uint64_t result=0;
+    uint64_t bit=uint64_t(1)<<62;
+    while (bit>value) bit>>=2;
+    while (bit!=0){
+        if (value>=result+bit){
+            value-=result+bit;
+            result=(result>>1)+bit;
+        } else {
+            result>>=1;
+        }
+        bit>>=2;
+    }
+    return Fixed::fromRaw(static_cast<int32_t>(result));
+
+}
+
+Fixed sin(Fixed radians){
+    return Fixed::fromRaw(sinPhase(toPhase(radians)));
+}
+
+Fixed cos(Fixed radians){
+    return Fixed::fromRaw(sinPhase(toPhase(radians)+(1u<<(kPhaseBits-2))));
+}
+
+} // namespace fixedpoint
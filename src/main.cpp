@@ -7,37 +7,34 @@
 #include "core/Transform.hpp"
 #include "visuals/Visuals.hpp"
 
+static void addStaticBox(World& world, Real width, Real height, const Vec2& position, Real rotation){
+
+    // Builds the box outline ( counter-clockwise, so the edges face outwards ) and adds it as a loop chain.
+
+    RigidBody box;
+    box.position=position;
+    box.rotation=rotation;
+    setBoxVertices(box, width, height);
+    physEng::worldSpace(box);
+
+    ChainDef chain;
+    chain.points=box.transformedVertices.data();
+    chain.count=box.transformedVertices.size();
+    chain.loop=true;
+    chain.restitution=1.0f;
+    world.createChain(chain);
+
+}
+
 int main(){
 
     World world;
     Visuals gfx(world);
 
-    RigidBody floor;
-    setBoxVertices(floor, 30.0f, 30.0f);    
-    floor.snapTo(Vec2(0.0f, -27.0f));         
-    floor.rotate(1.5708f);                  
-    floor.colour = Colour{150.0f, 255.0f, 255.0f};
-    floor.isStatic=true;
-    floor.restitution=1.0f;
-    world.getBodies().push_back(floor);
-
-    RigidBody incline;
-    setBoxVertices(incline, 10.0f, 0.8f);    
-    incline.snapTo(Vec2(-11.0f, 3));         
-    incline.rotate(1.5708*-0.05f);                  
-    incline.colour = Colour{150.0f, 255.0f, 255.0f};
-    incline.isStatic=true;
-    incline.restitution=1.0f;
-    world.getBodies().push_back(incline);
-
-    RigidBody floor2;
-    setBoxVertices(floor2, 15.0f, 0.6f);    
-    floor2.snapTo(Vec2(10.0f, 0.9f));         
-    floor2.rotate(1.5708*0.2f);                  
-    floor2.colour = Colour{150.0f, 255.0f, 255.0f};
-    floor2.isStatic=true;
-    floor2.restitution=1.0f;
-    world.getBodies().push_back(floor2);
+    // Static terrain as closed edge loops around the old box outlines
+    addStaticBox(world, 30.0f, 30.0f, Vec2(0.0f, -27.0f), 1.5708f);
+    addStaticBox(world, 10.0f, 0.8f, Vec2(-11.0f, 3), 1.5708*-0.05f);
+    addStaticBox(world, 15.0f, 0.6f, Vec2(10.0f, 0.9f), 1.5708*0.2f);
 
     for (int i=0;i<50;i++){
         int test=10;
@@ -49,6 +46,7 @@ int main(){
         t4.staticFriction=0.8;
         t4.restitution=0.2f;
         t4.linearVelocity=Vec2(20.0f,0.0f);
+        t4.isBullet=true; // Fast enough to tunnel through floor2 without CCD
         world.getBodies().push_back(t4);
     }
 
@@ -0,0 +1,59 @@
+// mapped_file.cpp
+// POSIX implementation of MappedFile ( mmap ).
+
+#include "io/MappedFile.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data,nullptr)), m_size(std::exchange(other.m_size,0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept{
+    if (this!=&other){
+        close();
+        m_data=std::exchange(other.m_data,nullptr);
+        m_size=std::exchange(other.m_size,0);
+    }
+    return *this;
+}
+
+bool MappedFile::open(const std::string& path){
+
+    // Maps the file at path read-only into memory.
+    // The file descriptor is closed straight away, the mapping keeps the file alive.
+
+    close();
+
+    int fd=::open(path.c_str(),O_RDONLY);
+    if (fd<0) return false;
+
+    struct stat st{};
+    if (fstat(fd,&st)!=0 || st.st_size<=0){
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped=mmap(nullptr,static_cast<size_t>(st.st_size),PROT_READ,MAP_PRIVATE,fd,0);
+    ::close(fd);
+    if (mapped==MAP_FAILED) return false;
+
+    m_data=static_cast<const unsigned char*>(mapped);
+    m_size=static_cast<size_t>(st.st_size);
+    return true;
+
+}
+
+void MappedFile::close(){
+    if (m_data){
+        munmap(const_cast<unsigned char*>(m_data),m_size);
+        m_data=nullptr;
+        m_size=0;
+    }
+}
@@ -0,0 +1,401 @@
+// query.cpp
+// Spatial queries against the broad-phase grid ( ray casts, region queries and shape casts ).
+
+#include "core/World.hpp"
+#include "collision/Collision.hpp"
+#include "collision/Compound.hpp"
+#include "core/Transform.hpp"
+#include "math/Math.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+bool raySlab(const Vec2& origin,const Vec2& delta,const AABB& box,Real& tEnter,Real& tExit){
+
+    // Clips the segment origin + t*delta against box using the slab method.
+    // On entry tEnter/tExit hold the allowed interval, on success they hold the clipped one.
+
+    const Real o[2]={origin.x,origin.y};
+    const Real d[2]={delta.x,delta.y};
+    const Real lo[2]={box.min.x,box.min.y};
+    const Real hi[2]={box.max.x,box.max.y};
+
+    for (int axis=0;axis<2;++axis){
+        if (d[axis]==0.0f){
+            if (o[axis]<lo[axis] || o[axis]>hi[axis]) return false;
+            continue;
+        }
+        Real inv=1.0f/d[axis];
+        Real t0=(lo[axis]-o[axis])*inv;
+        Real t1=(hi[axis]-o[axis])*inv;
+        if (t0>t1) std::swap(t0,t1);
+        tEnter=std::max(tEnter,t0);
+        tExit=std::min(tExit,t1);
+        if (tEnter>tExit) return false;
+    }
+    return true;
+
+}
+
+struct WalkCell{
+    int x, y; // The cell being visited
+    int fromX, fromY; // The cell the walk stepped in from, the same cell for the first one
+};
+
+bool entersRange(const WalkCell& cell,const partioning::CellRange& r){
+    // The walk moves one cell at a time and never turns back on either axis, so it crosses a body's
+    // rectangle of cells exactly once: the body is new here iff the previous cell lay outside it.
+    const bool fromInside=cell.fromX>=r.x0 && cell.fromX<=r.x1 && cell.fromY>=r.y0 && cell.fromY<=r.y1;
+    return !fromInside || (cell.fromX==cell.x && cell.fromY==cell.y);
+}
+
+template <typename Visit>
+void walkGrid(const partioning::SpatialGrid& grid,const Vec2& origin,const Vec2& delta,Visit&& visit){
+
+    // Amanatides-Woo traversal of every grid cell the segment crosses, nearest first.
+    // visit(first, last, tCell, cell) is called per occupied cell with the cell's entries, the fraction
+    // at which the segment enters it and its coordinates, and returns false to stop the walk ( early out
+    // on a closer hit ).
+
+    Real tStart=0.0f, tEnd=1.0f;
+    if (!raySlab(origin,delta,grid.bounds(),tStart,tEnd)) return;
+
+    const Real cellSize=grid.config.cellSize;
+    Vec2 start=origin+delta*tStart;
+    Vec2 end=origin+delta*tEnd;
+
+    int cx=partioning::cellCoord(start.x,cellSize);
+    int cy=partioning::cellCoord(start.y,cellSize);
+    const int endX=partioning::cellCoord(end.x,cellSize);
+    const int endY=partioning::cellCoord(end.y,cellSize);
+
+    const Real inf=std::numeric_limits<Real>::infinity();
+    const int stepX=delta.x>0.0f ? 1 : (delta.x<0.0f ? -1 : 0);
+    const int stepY=delta.y>0.0f ? 1 : (delta.y<0.0f ? -1 : 0);
+    const Real deltaX=stepX ? cellSize/std::abs(delta.x) : inf;
+    const Real deltaY=stepY ? cellSize/std::abs(delta.y) : inf;
+    Real nextX=stepX>0 ? ((cx+1)*cellSize-origin.x)/delta.x : (stepX<0 ? (cx*cellSize-origin.x)/delta.x : inf);
+    Real nextY=stepY>0 ? ((cy+1)*cellSize-origin.y)/delta.y : (stepY<0 ? (cy*cellSize-origin.y)/delta.y : inf);
+
+    Real tCell=tStart;
+    int remaining=std::abs(endX-cx)+std::abs(endY-cy)+1; // Cells on the path, bounds the loop
+    WalkCell cell{cx,cy,cx,cy};
+
+    while (remaining-- > 0){
+        cell.x=cx;
+        cell.y=cy;
+        auto [first,last]=grid.cell(cx,cy);
+        if (first!=last && !visit(first,last,tCell,cell)) return;
+        cell.fromX=cx;
+        cell.fromY=cy;
+
+        if (nextX<nextY){
+            tCell=nextX;
+            nextX+=deltaX;
+            cx+=stepX;
+        } else {
+            tCell=nextY;
+            nextY+=deltaY;
+            cy+=stepY;
+        }
+        if (tCell>tEnd) return;
+    }
+
+}
+
+bool rayBody(const Vec2& origin,const Vec2& delta,const RigidBody& body,Real maxFraction,Real& fraction,Vec2& normal){
+
+    // rayPolygon() over every piece of a body, keeping the nearest entry. Rays starting inside any
+    // piece do not hit, so the faces shared between a compound body's pieces are never reported.
+
+    if (!body.isCompound()) return rayPolygon(origin,delta,body.transformedVertices,maxFraction,fraction,normal);
+
+    if (!forEachPiece(body,[&](VertexSpan piece){ return !pointInPolygon(origin,piece); })) return false;
+
+    bool found=false;
+    forEachPiece(body,[&](VertexSpan piece){
+        Real f;
+        Vec2 n;
+        if (rayPolygon(origin,delta,piece,maxFraction,f,n)){
+            maxFraction=f;
+            fraction=f;
+            normal=n;
+            found=true;
+        }
+        return true;
+    });
+    return found;
+
+}
+
+bool rayEdge(const Vec2& origin,const Vec2& delta,const EdgeShape& edge,Real maxFraction,Real& fraction){
+
+    // Edges are one-sided: only rays starting in front and heading into the front face hit.
+
+    const Real approach=vecMath::dot(delta,edge.normal);
+    const Real height=vecMath::dot(origin-edge.v1,edge.normal);
+    if (approach>=0.0f || height<0.0f) return false;
+
+    const Real t=-height/approach;
+    if (t>maxFraction) return false;
+    const Vec2 along=edge.v2-edge.v1;
+    const Real s=vecMath::dot(origin+delta*t-edge.v1,along);
+    if (s<0.0f || s>along.lengthSquared()) return false;
+    fraction=t;
+    return true;
+
+}
+
+template <typename Visit>
+void walkStatic(const StaticGeometry& geometry,const Vec2& origin,const Vec2& delta,const Real& maxFraction,Visit&& visit){
+
+    // Depth-first walk of the static BVH along origin + t*delta, skipping nodes the segment misses or only
+    // reaches beyond maxFraction ( read on every node, so visit() can shrink it ). visit(edgeIndex, edge).
+
+    if (geometry.nodeCount()==0) return;
+
+    constexpr int kStackSize=128;
+    uint32_t stack[kStackSize];
+    int top=0;
+    stack[top++]=0;
+
+    const BVHNode* nodes=geometry.nodes();
+    const EdgeShape* edges=geometry.edges();
+    while (top>0){
+        const BVHNode& node=nodes[stack[--top]];
+        Real tEnter=0.0f, tExit=maxFraction;
+        if (!raySlab(origin,delta,node.box,tEnter,tExit)) continue;
+
+        if (node.count>0){
+            for (uint32_t i=node.index;i<node.index+node.count;++i) visit(i,edges[i]);
+        } else if (top+2<=kStackSize){
+            stack[top++]=node.index;
+            stack[top++]=static_cast<uint32_t>(&node-nodes)+1;
+        }
+    }
+
+}
+
+} // namespace
+
+void World::refreshBroadphase(){
+
+    // Brings world-space vertices, AABBs and the grid in line with the current bodies,
+    // so const queries can run between steps.
+
+    assignIds();
+    m_aabbs.clear();
+    m_aabbs.reserve(m_bodies.size());
+    for (auto& body : m_bodies){
+        physEng::worldSpace(body);
+        m_aabbs.push_back(body.transformedVertices.empty() ? AABB{body.position,body.position} : getAABB(body));
+    }
+    m_grid.build(m_aabbs);
+
+}
+
+bool World::rayCast(const Vec2& from, const Vec2& to, RayCastHit& hit, bool includeSensors) const{
+
+    // Closest hit along from->to. Cells are visited nearest first, so the walk stops as soon
+    // as the next cell starts beyond the best hit found so far.
+
+    hit=RayCastHit{};
+    if (m_grid.bodyCount()!=m_bodies.size()) return false; // Grid is stale, see refreshBroadphase()
+
+    const Vec2 delta=to-from;
+    Real best=1.0f;
+    bool found=false;
+
+    // Edges first, so a hit on the terrain already bounds the grid walk
+    walkStatic(*m_static,from,delta,best,[&](uint32_t,const EdgeShape& edge){
+        Real fraction;
+        if (!rayEdge(from,delta,edge,best,fraction) || (found && fraction>=best)) return;
+        best=fraction;
+        found=true;
+        hit.chain=ChainHandle{edge.chain};
+        hit.normal=edge.normal;
+        hit.fraction=fraction;
+    });
+
+    walkGrid(m_grid,from,delta,[&](const partioning::CellEntry* first,const partioning::CellEntry* last,Real tCell,const WalkCell&){
+        if (found && tCell>best) return false;
+
+        for (const auto* e=first;e!=last;++e){
+            const RigidBody& body=m_bodies[e->body];
+            if (body.isSensor && !includeSensors) continue;
+            Real tEnter=0.0f, tExit=best;
+            if (!raySlab(from,delta,m_aabbs[e->body],tEnter,tExit)) continue;
+
+            Real fraction;
+            Vec2 normal;
+            if (!rayBody(from,delta,body,best,fraction,normal)) continue;
+            if (found && fraction>=best) continue;
+
+            best=fraction;
+            found=true;
+            hit.body=BodyHandle{body.id};
+            hit.chain=ChainHandle{};
+            hit.index=e->body;
+            hit.normal=normal;
+            hit.fraction=fraction;
+        }
+        return true;
+    });
+
+    if (found) hit.point=from+delta*hit.fraction;
+    return found;
+
+}
+
+size_t World::rayCastAll(const Vec2& from, const Vec2& to, std::vector<RayCastHit>& hits, bool includeSensors) const{
+
+    // Every body and edge crossed by from->to, sorted nearest first. hits is cleared first.
+
+    hits.clear();
+    if (m_grid.bodyCount()!=m_bodies.size()) return 0;
+
+    const Vec2 delta=to-from;
+
+    const Real whole=1.0f;
+    walkStatic(*m_static,from,delta,whole,[&](uint32_t,const EdgeShape& edge){
+        RayCastHit hit;
+        if (!rayEdge(from,delta,edge,1.0f,hit.fraction)) return;
+        hit.chain=ChainHandle{edge.chain};
+        hit.normal=edge.normal;
+        hit.point=from+delta*hit.fraction;
+        hits.push_back(hit);
+    });
+
+    // Like queryAABB(), a body spanning several cells is only tested in the first cell of its range the
+    // walk reaches, so every body is tested once and nothing needs deduplicating afterwards
+    walkGrid(m_grid,from,delta,[&](const partioning::CellEntry* first,const partioning::CellEntry* last,Real,const WalkCell& cell){
+        for (const auto* e=first;e!=last;++e){
+            if (!entersRange(cell,m_grid.range(e->body))) continue;
+            const RigidBody& body=m_bodies[e->body];
+            if (body.isSensor && !includeSensors) continue;
+            Real tEnter=0.0f, tExit=1.0f;
+            if (!raySlab(from,delta,m_aabbs[e->body],tEnter,tExit)) continue;
+
+            RayCastHit hit;
+            if (!rayBody(from,delta,body,1.0f,hit.fraction,hit.normal)) continue;
+            hit.body=BodyHandle{body.id};
+            hit.index=e->body;
+            hit.point=from+delta*hit.fraction;
+            hits.push_back(hit);
+        }
+        return true;
+    });
+
+    std::sort(hits.begin(),hits.end(),[](const RayCastHit& a,const RayCastHit& b){
+        return a.fraction<b.fraction || (a.fraction==b.fraction && a.index<b.index);
+    });
+    return hits.size();
+
+}
+
+void World::rayCastMany(const RayInput* rays, size_t count, RayCastHit* hits, bool includeSensors) const{
+
+    // Batched closest-hit casts. Nothing is allocated and the World is only read,
+    // so large batches can be split across threads by the caller.
+
+    for (size_t i=0;i<count;++i){
+        rayCast(rays[i].from,rays[i].to,hits[i],includeSensors);
+    }
+
+}
+
+size_t World::queryAABB(const AABB& box, BodyHandle* out, size_t capacity) const{
+    size_t found=0;
+    queryAABB(box,[&](int,const RigidBody& body){
+        if (found<capacity) out[found]=BodyHandle{body.id};
+        ++found;
+        return true;
+    });
+    return found;
+}
+
+size_t World::queryPoint(const Vec2& point, BodyHandle* out, size_t capacity) const{
+    size_t found=0;
+    queryPoint(point,[&](int,const RigidBody& body){
+        if (found<capacity) out[found]=BodyHandle{body.id};
+        ++found;
+        return true;
+    });
+    return found;
+}
+
+bool World::shapeCast(const std::vector<Vec2>& localVertices, Real rotation, const Vec2& from, const Vec2& to,
+                      ShapeCastHit& hit, BodyHandle ignore, bool includeSensors) const{
+
+    // Collects candidates under the swept AABB ( start and end poses ), then runs the exact
+    // swept SAT against each, shrinking the search fraction as closer hits are found.
+
+    hit=ShapeCastHit{};
+    if (localVertices.size()<3) return false;
+
+    Transform start(from,rotation);
+    std::vector<Vec2> swept;
+    swept.reserve(localVertices.size());
+    for (const Vec2& v : localVertices) swept.push_back(start.applyTransform(v));
+
+    const Vec2 delta=to-from;
+    AABB box{swept[0],swept[0]};
+    for (const Vec2& v : swept){
+        box.min.x=std::min(box.min.x,std::min(v.x,v.x+delta.x));
+        box.min.y=std::min(box.min.y,std::min(v.y,v.y+delta.y));
+        box.max.x=std::max(box.max.x,std::max(v.x,v.x+delta.x));
+        box.max.y=std::max(box.max.y,std::max(v.y,v.y+delta.y));
+    }
+
+    Real best=1.0f;
+    bool found=false;
+
+    queryAABB(box,[&](int index,const RigidBody& body){
+        if (ignore.isValid() && body.id==ignore.id) return true;
+        if (body.isSensor && !includeSensors) return true;
+
+        forEachPieceNear(body,box,[&](VertexSpan piece){
+            Real fraction;
+            Vec2 normal,point;
+            if (!sweepPolygons(swept,delta,piece,best,fraction,normal,point)) return true;
+            if (found && fraction>=best) return true;
+
+            best=fraction;
+            found=true;
+            hit.body=BodyHandle{body.id};
+            hit.index=index;
+            hit.point=point;
+            hit.normal=normal;
+            hit.fraction=fraction;
+            return best>0.0f;
+        });
+        return !found || best>0.0f; // Nothing can beat an initial overlap
+    });
+
+    // Edges block casts that start in front of them, like bodies whose centre is in front
+    Vec2 centre(0.0f,0.0f);
+    for (const Vec2& v : swept) centre+=v;
+    centre=centre*(1.0f/static_cast<Real>(swept.size()));
+    m_static->query(box,[&](uint32_t,const EdgeShape& edge){
+        if (found && best<=0.0f) return;
+        if (vecMath::dot(centre-edge.v1,edge.normal)<0.0f || vecMath::dot(delta,edge.normal)>=0.0f) return;
+
+        const Vec2 segment[2]={edge.v1,edge.v2};
+        Real fraction;
+        Vec2 normal,point;
+        if (!sweepPolygons(swept,delta,VertexSpan(segment,2),best,fraction,normal,point)) return;
+        if (found && fraction>=best) return;
+
+        best=fraction;
+        found=true;
+        hit=ShapeCastHit{};
+        hit.chain=ChainHandle{edge.chain};
+        hit.point=point;
+        hit.normal=normal;
+        hit.fraction=fraction;
+    });
+
+    return found;
+
+}
@@ -0,0 +1,368 @@
+// recorder.cpp
+// Delta-encoded transform recording and playback ( format documented in io/Recorder.hpp ).
+
+#include "io/Recorder.hpp"
+#include "io/ByteStream.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace recording {
+
+bool decodeFrame(const unsigned char*& cursor,const unsigned char* end,std::vector<QuantizedTransform>& state){
+
+    // Applies one encoded frame on top of state.
+    // Keyframes overwrite state entirely, delta frames only touch the bodies they list.
+
+    uint64_t type,bodyCount;
+    if (!bytes::readVarint(cursor,end,type) || !bytes::readVarint(cursor,end,bodyCount)) return false;
+
+    if (type==1){
+        if (bodyCount>static_cast<uint64_t>(end-cursor)) return false; // Every body takes at least one byte
+        state.resize(bodyCount);
+        uint64_t id=0;
+        for (size_t i=0;i<state.size();++i){
+            auto& t=state[i];
+            uint64_t gap;
+            if (!bytes::readVarint(cursor,end,gap)) return false;
+            if (i>0 && gap==0) return false; // Ids are unique and ascending
+            id+=gap;
+            if (id>UINT32_MAX) return false;
+            t.id=static_cast<uint32_t>(id);
+            if (!bytes::readZigzag(cursor,end,t.x) ||
+                !bytes::readZigzag(cursor,end,t.y) ||
+                !bytes::readZigzag(cursor,end,t.rotation)) return false;
+        }
+        return true;
+    }
+
+    if (bodyCount!=state.size()) return false; // Deltas never change the body count
+
+    uint64_t changed;
+    if (!bytes::readVarint(cursor,end,changed)) return false;
+
+    // Changed ids ascend, so the matching slot is always at or after the previous one
+    auto slot=state.begin();
+    uint64_t id=0;
+    for (uint64_t c=0;c<changed;++c){
+        uint64_t gap;
+        int64_t dx,dy,dr;
+        if (!bytes::readVarint(cursor,end,gap)) return false;
+        if (c>0 && gap==0) return false;
+        id+=gap;
+        slot=std::lower_bound(slot,state.end(),id,[](const QuantizedTransform& t,uint64_t key){ return t.id<key; });
+        if (slot==state.end() || slot->id!=id) return false;
+        const size_t index=static_cast<size_t>(slot-state.begin());
+        if (!bytes::readZigzag(cursor,end,dx) ||
+            !bytes::readZigzag(cursor,end,dy) ||
+            !bytes::readZigzag(cursor,end,dr)) return false;
+        state[index].x+=dx;
+        state[index].y+=dy;
+        state[index].rotation+=dr;
+    }
+    return true;
+
+}
+
+namespace {
+
+constexpr size_t kMinMatch=4;
+constexpr int kHashBits=14;
+
+uint32_t load32(const unsigned char* p){
+    uint32_t v;
+    std::memcpy(&v,p,sizeof(v));
+    return v;
+}
+
+} // namespace
+
+void compress(const unsigned char* data,size_t size,std::vector<unsigned char>& out){
+
+    // Greedy matching through a hash of the next 4 bytes, which keeps only the latest position per bucket.
+    // Unchanged bodies repeat the same short byte runs every frame, which is what this catches.
+
+    out.clear();
+    std::vector<uint32_t> table(size_t(1)<<kHashBits,UINT32_MAX);
+    size_t anchor=0;
+    size_t i=0;
+    while (i+kMinMatch<=size){
+        const uint32_t key=load32(data+i);
+        uint32_t& slot=table[(key*2654435761u)>>(32-kHashBits)];
+        const size_t candidate=slot;
+        slot=static_cast<uint32_t>(i);
+        if (candidate==UINT32_MAX || load32(data+candidate)!=key){
+            ++i;
+            continue;
+        }
+
+        size_t length=kMinMatch;
+        while (i+length<size && data[candidate+length]==data[i+length]) ++length;
+        bytes::writeVarint(out,i-anchor);
+        out.insert(out.end(),data+anchor,data+i);
+        bytes::writeVarint(out,length-kMinMatch);
+        bytes::writeVarint(out,i-candidate);
+        i+=length;
+        anchor=i;
+    }
+    bytes::writeVarint(out,size-anchor);
+    out.insert(out.end(),data+anchor,data+size);
+
+}
+
+bool decompress(const unsigned char* data,size_t size,size_t rawBytes,std::vector<unsigned char>& out){
+
+    out.clear();
+    out.reserve(rawBytes);
+    const unsigned char* cursor=data;
+    const unsigned char* end=data+size;
+    while (cursor<end){
+        uint64_t literals;
+        if (!bytes::readVarint(cursor,end,literals) || literals>static_cast<uint64_t>(end-cursor) ||
+            literals>rawBytes-out.size()) return false;
+        out.insert(out.end(),cursor,cursor+literals);
+        cursor+=literals;
+        if (cursor==end) break;
+
+        uint64_t length, offset;
+        if (!bytes::readVarint(cursor,end,length) || !bytes::readVarint(cursor,end,offset)) return false;
+        if (offset==0 || offset>out.size() || rawBytes-out.size()<kMinMatch || length>rawBytes-out.size()-kMinMatch) return false;
+        length+=kMinMatch;
+        for (size_t from=out.size()-offset;length>0;--length) out.push_back(out[from++]); // May overlap itself
+    }
+    return out.size()==rawBytes;
+
+}
+
+} // namespace recording
+
+Recorder::~Recorder(){
+    close();
+}
+
+bool Recorder::open(const std::string& path,const RecorderConfig& config){
+    close();
+    std::FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file) return false;
+    m_file=file;
+    m_ownsFile=true;
+    m_config=config;
+    beginStream();
+    return true;
+}
+
+bool Recorder::open(std::FILE* stream,const RecorderConfig& config){
+    close();
+    if (!stream) return false;
+    m_file=stream;
+    m_ownsFile=false;
+    m_config=config;
+    beginStream();
+    return true;
+}
+
+void Recorder::beginStream(){
+
+    // Resets encoder state and writes the stream header.
+
+    m_frame=0;
+    m_failed=false;
+    m_blockFirstFrame=0;
+    m_blockFrames=0;
+    m_blockKeyframe=false;
+    m_previous.clear();
+    m_block.clear();
+    m_block.reserve(m_config.blockBytes+1024);
+
+    recording::RecordingHeader header;
+    header.positionPrecision=m_config.positionPrecision;
+    header.rotationPrecision=m_config.rotationPrecision;
+    header.keyframeInterval=m_config.keyframeInterval;
+    m_bytesWritten=0;
+    write(&header,sizeof(header));
+
+}
+
+void Recorder::write(const void* data,size_t size){
+    if (m_failed) return;
+    if (std::fwrite(data,1,size,m_file)!=size) m_failed=true;
+    else m_bytesWritten+=size;
+}
+
+void Recorder::close(){
+    if (!m_file) return;
+    flushBlock();
+    if (std::fflush(m_file)!=0) m_failed=true;
+    if (m_ownsFile && std::fclose(m_file)!=0) m_failed=true;
+    m_file=nullptr;
+    m_ownsFile=false;
+}
+
+void Recorder::flushBlock(){
+
+    // Writes the pending frames as one block ( header + payload ).
+
+    if (m_blockFrames==0) return;
+
+    recording::BlockHeader header;
+    header.firstFrame=m_blockFirstFrame;
+    header.frameCount=m_blockFrames;
+    header.startsWithKeyframe=m_blockKeyframe;
+
+    const std::vector<unsigned char>* payload=&m_block;
+    if (m_config.compress){
+        recording::compress(m_block.data(),m_block.size(),m_compressed);
+        if (m_compressed.size()<m_block.size()){ // Stored as is when compression does not pay
+            payload=&m_compressed;
+            header.rawBytes=static_cast<uint32_t>(m_block.size());
+        }
+    }
+    header.payloadBytes=static_cast<uint32_t>(payload->size());
+
+    write(&header,sizeof(header));
+    write(payload->data(),payload->size());
+
+    m_block.clear();
+    m_blockFrames=0;
+    m_blockFirstFrame=m_frame;
+    m_blockKeyframe=false;
+
+}
+
+void Recorder::recordFrame(const std::vector<RigidBody>& bodies){
+
+    // Quantizes the current transforms and appends either a keyframe or a delta frame.
+    // Frames are keyed by body id, so a keyframe is forced on the interval and whenever the set of ids
+    // changes ( bodies are added or culled, even in the same step ).
+
+    if (!m_file || m_failed) return;
+
+    m_current.resize(bodies.size());
+    for (size_t i=0;i<bodies.size();++i){
+        const RigidBody& body=bodies[i];
+        m_current[i].id=body.id;
+        m_current[i].x=bytes::quantize(body.position.x,m_config.positionPrecision);
+        m_current[i].y=bytes::quantize(body.position.y,m_config.positionPrecision);
+        m_current[i].rotation=bytes::quantize(body.rotation,m_config.rotationPrecision);
+    }
+
+    // World order is creation order until bodies are removed, so the sort is usually a single pass
+    auto byId=[](const recording::QuantizedTransform& a,const recording::QuantizedTransform& b){ return a.id<b.id; };
+    if (!std::is_sorted(m_current.begin(),m_current.end(),byId)) std::sort(m_current.begin(),m_current.end(),byId);
+
+    bool keyframe = m_frame==0 ||
+                    m_current.size()!=m_previous.size() ||
+                    (m_config.keyframeInterval>0 && m_frame%m_config.keyframeInterval==0);
+    for (size_t i=0;i<m_current.size() && !keyframe;++i){
+        keyframe=m_current[i].id!=m_previous[i].id;
+    }
+
+    if (keyframe){
+        flushBlock(); // Keyframes always open a block so readers can seek to them
+        m_blockKeyframe=true;
+        bytes::writeVarint(m_block,1);
+        bytes::writeVarint(m_block,m_current.size());
+        uint32_t id=0;
+        for (const auto& t : m_current){
+            bytes::writeVarint(m_block,t.id-id);
+            id=t.id;
+            bytes::writeZigzag(m_block,t.x);
+            bytes::writeZigzag(m_block,t.y);
+            bytes::writeZigzag(m_block,t.rotation);
+        }
+    } else {
+        size_t changed=0;
+        for (size_t i=0;i<m_current.size();++i){
+            if (m_current[i]!=m_previous[i]) ++changed;
+        }
+
+        bytes::writeVarint(m_block,0);
+        bytes::writeVarint(m_block,m_current.size());
+        bytes::writeVarint(m_block,changed);
+
+        uint32_t id=0; // Id of the last written body
+        for (size_t i=0;i<m_current.size() && changed>0;++i){
+            const auto& cur=m_current[i];
+            const auto& prev=m_previous[i];
+            if (cur==prev) continue;
+            bytes::writeVarint(m_block,cur.id-id);
+            bytes::writeZigzag(m_block,cur.x-prev.x);
+            bytes::writeZigzag(m_block,cur.y-prev.y);
+            bytes::writeZigzag(m_block,cur.rotation-prev.rotation);
+            id=cur.id;
+        }
+    }
+
+    m_previous.swap(m_current);
+    ++m_frame;
+    ++m_blockFrames;
+
+    if (m_block.size()>=m_config.blockBytes) flushBlock();
+
+}
+
+bool RecordingReader::open(const std::string& path){
+
+    // Maps the recording and indexes its blocks. Payloads are decoded lazily in readFrame().
+
+    m_blocks.clear();
+    m_frameCount=0;
+    if (!m_file.open(path) || m_file.size()<sizeof(recording::RecordingHeader)) return false;
+
+    std::memcpy(&m_header,m_file.data(),sizeof(m_header));
+    if (m_header.magic!=recording::kRecordingMagic || m_header.version!=recording::kRecordingVersion) return false;
+
+    size_t offset=sizeof(m_header);
+    while (offset+sizeof(recording::BlockHeader)<=m_file.size()){
+        BlockRef ref;
+        std::memcpy(&ref.header,m_file.data()+offset,sizeof(ref.header));
+        ref.payloadOffset=offset+sizeof(ref.header);
+        if (ref.header.magic!=recording::kBlockMagic) return false;
+        if (ref.payloadOffset+ref.header.payloadBytes>m_file.size()) break; // Truncated tail ( e.g. a live recording )
+        if (ref.header.rawBytes>(1u<<28)) return false; // No recorder writes blocks this large
+        m_blocks.push_back(ref);
+        m_frameCount=ref.header.firstFrame+ref.header.frameCount;
+        offset=ref.payloadOffset+ref.header.payloadBytes;
+    }
+    return true;
+
+}
+
+bool RecordingReader::readFrame(uint32_t frame,std::vector<uint32_t>& ids,std::vector<Vec2>& positions,std::vector<Real>& rotations){
+
+    if (frame>=m_frameCount || m_blocks.empty()) return false;
+
+    // Find the last keyframe block starting at or before frame
+    size_t start=0;
+    for (size_t b=0;b<m_blocks.size() && m_blocks[b].header.firstFrame<=frame;++b){
+        if (m_blocks[b].header.startsWithKeyframe) start=b;
+    }
+
+    std::vector<recording::QuantizedTransform> state;
+    uint32_t current=m_blocks[start].header.firstFrame;
+    for (size_t b=start;b<m_blocks.size();++b){
+        const unsigned char* cursor=m_file.data()+m_blocks[b].payloadOffset;
+        const unsigned char* end=cursor+m_blocks[b].header.payloadBytes;
+        if (m_blocks[b].header.rawBytes){
+            if (!recording::decompress(cursor,end-cursor,m_blocks[b].header.rawBytes,m_decompressed)) return false;
+            cursor=m_decompressed.data();
+            end=cursor+m_decompressed.size();
+        }
+        for (uint32_t f=0;f<m_blocks[b].header.frameCount;++f,++current){
+            if (!recording::decodeFrame(cursor,end,state)) return false;
+            if (current==frame){
+                ids.resize(state.size());
+                positions.resize(state.size());
+                rotations.resize(state.size());
+                for (size_t i=0;i<state.size();++i){
+                    ids[i]=state[i].id;
+                    positions[i]=Vec2(bytes::dequantize(state[i].x,m_header.positionPrecision),
+                                      bytes::dequantize(state[i].y,m_header.positionPrecision));
+                    rotations[i]=bytes::dequantize(state[i].rotation,m_header.rotationPrecision);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+
+}
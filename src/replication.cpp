@@ -0,0 +1,358 @@
+// replication.cpp
+// Interest-managed, delta-compressed state replication over UDP ( see io/Replication.hpp ).
+
+#include "io/Replication.hpp"
+#include "io/ByteStream.hpp"
+#include "math/Math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using replication::QuantizedBody;
+
+namespace {
+
+void writeHeader(std::vector<unsigned char>& out,uint8_t type){
+    const uint32_t magic=replication::kReplicationMagic;
+    out.resize(sizeof(magic));
+    std::memcpy(out.data(),&magic,sizeof(magic));
+    out.push_back(type);
+}
+
+void writeNonce(std::vector<unsigned char>& out,uint32_t nonce){
+    unsigned char raw[sizeof(nonce)];
+    std::memcpy(raw,&nonce,sizeof(nonce));
+    out.insert(out.end(),raw,raw+sizeof(raw));
+}
+
+bool readNonce(const unsigned char*& cursor,const unsigned char* end,uint32_t& nonce){
+    if (end-cursor<static_cast<std::ptrdiff_t>(sizeof(nonce))) return false;
+    std::memcpy(&nonce,cursor,sizeof(nonce));
+    cursor+=sizeof(nonce);
+    return true;
+}
+
+bool readHeader(const unsigned char*& cursor,const unsigned char* end,uint8_t type){
+    uint32_t magic;
+    if (end-cursor<static_cast<std::ptrdiff_t>(sizeof(magic)+1)) return false;
+    std::memcpy(&magic,cursor,sizeof(magic));
+    cursor+=sizeof(magic);
+    return magic==replication::kReplicationMagic && *cursor++==type;
+}
+
+void writeFloat(std::vector<unsigned char>& out,float value){
+    unsigned char raw[sizeof(float)];
+    std::memcpy(raw,&value,sizeof(value));
+    out.insert(out.end(),raw,raw+sizeof(raw));
+}
+
+bool readFloat(const unsigned char*& cursor,const unsigned char* end,float& value){
+    if (end-cursor<static_cast<std::ptrdiff_t>(sizeof(float))) return false;
+    std::memcpy(&value,cursor,sizeof(value));
+    cursor+=sizeof(value);
+    return true;
+}
+
+// Finds the entry for id in a view sorted by id, advancing from a running index
+const QuantizedBody* match(const std::vector<QuantizedBody>& view,size_t& index,uint32_t id){
+    while (index<view.size() && view[index].id<id) ++index;
+    return (index<view.size() && view[index].id==id) ? &view[index] : nullptr;
+}
+
+} // namespace
+
+// --- Server
+
+ReplicationServer::ReplicationServer(const ReplicationConfig& config) : m_config(config) {
+    m_config.history=std::max<uint32_t>(1,m_config.history);
+    m_config.maxBodies=std::min(m_config.maxBodies,replication::kMaxViewBodies); // More could never fit a datagram
+    std::random_device entropy;
+    m_secret=(uint64_t(entropy())<<32)^entropy();
+}
+
+bool ReplicationServer::open(uint16_t port, const std::string& address){
+    Endpoint local;
+    if (!resolve(address,port,local)) return false;
+    return m_socket.open(port,1<<20,local.address); // Acks from hundreds of clients arrive in bursts
+}
+
+uint32_t ReplicationServer::nonce(const Endpoint& endpoint) const{
+
+    // splitmix64 finalizer over the keyed endpoint. Never 0, which clients send before their first challenge.
+
+    uint64_t z=m_secret^((uint64_t(endpoint.address)<<16)|endpoint.port);
+    z=(z^(z>>30))*0xBF58476D1CE4E5B9ull;
+    z=(z^(z>>27))*0x94D049BB133111EBull;
+    z^=z>>31;
+    return static_cast<uint32_t>(z)|1u;
+
+}
+
+void ReplicationServer::poll(){
+
+    unsigned char buffer[replication::kMaxDatagram];
+    Endpoint from;
+    for (int size;(size=m_socket.receive(buffer,sizeof(buffer),from))>=0;){
+        const unsigned char* cursor=buffer;
+        const unsigned char* end=buffer+size;
+        uint32_t echoed;
+        uint64_t ack;
+        int64_t x, y;
+        if (!readHeader(cursor,end,replication::kAckPacket) || !readNonce(cursor,end,echoed) ||
+            !bytes::readVarint(cursor,end,ack) || !bytes::readZigzag(cursor,end,x) || !bytes::readZigzag(cursor,end,y)){
+            m_stats.dropped++;
+            continue;
+        }
+
+        // Unverified senders only ever get a challenge, no larger than their ack, and leave no state behind
+        const uint32_t expected=nonce(from);
+        if (echoed!=expected){
+            writeHeader(m_packet,replication::kChallengePacket);
+            writeNonce(m_packet,expected);
+            m_socket.send(from,m_packet.data(),m_packet.size());
+            m_stats.challenges++;
+            continue;
+        }
+
+        auto it=std::lower_bound(m_clients.begin(),m_clients.end(),from,[](const Client& c,const Endpoint& e){ return c.endpoint<e; });
+        if (it==m_clients.end() || it->endpoint!=from){
+            if (m_clients.size()>=m_config.maxClients){
+                m_stats.rejectedClients++;
+                continue;
+            }
+            it=m_clients.insert(it,Client{});
+            it->endpoint=from;
+            it->history.resize(m_config.history);
+        }
+        Client& client=*it;
+        if (ack>client.acked && ack<=m_sequence) client.acked=static_cast<uint32_t>(ack);
+        client.observer=Vec2(static_cast<Real>(bytes::dequantize(x,replication::kObserverStep)),
+                             static_cast<Real>(bytes::dequantize(y,replication::kObserverStep)));
+        client.lastHeard=m_sequence;
+    }
+    m_stats.clients=m_clients.size();
+
+}
+
+void ReplicationServer::gather(const World& world, const Client& client){
+
+    // Broad-phase query around the observer, cut to the radius, then to the nearest maxBodies. m_gathered
+    // is left nearest first, so encode() can cut it from the far end.
+
+    const Real radius=m_config.interestRadius;
+    const AABB box{client.observer-Vec2(radius,radius),client.observer+Vec2(radius,radius)};
+    m_nearest.clear();
+    world.queryAABB(box,[&](int index,const RigidBody& body){
+        const Real distance=vecMath::distanceSquared(body.position,client.observer);
+        if (distance<=radius*radius) m_nearest.push_back({distance,static_cast<uint32_t>(index)});
+        return true;
+    });
+    if (m_nearest.size()>m_config.maxBodies){
+        std::nth_element(m_nearest.begin(),m_nearest.begin()+m_config.maxBodies,m_nearest.end());
+        m_nearest.resize(m_config.maxBodies);
+    }
+    std::sort(m_nearest.begin(),m_nearest.end());
+
+    // Rotations are wrapped to ( -pi, pi ] so their varints stay small however long a body spins
+    const double turn=2.0*3.14159265358979323846;
+    const std::vector<RigidBody>& bodies=world.getBodies();
+    m_gathered.clear();
+    for (const auto& entry : m_nearest){
+        const RigidBody& body=bodies[entry.second];
+        m_gathered.push_back(QuantizedBody{body.id,
+                                           bytes::quantize(body.position.x,m_config.positionPrecision),
+                                           bytes::quantize(body.position.y,m_config.positionPrecision),
+                                           bytes::quantize(std::remainder(static_cast<double>(body.rotation),turn),m_config.rotationPrecision)});
+    }
+
+}
+
+const ReplicationServer::View* ReplicationServer::baseline(const Client& client) const{
+    if (client.acked==0) return nullptr;
+    const View& view=client.history[client.acked%m_config.history];
+    return view.sequence==client.acked ? &view : nullptr;
+}
+
+size_t ReplicationServer::encode(const View& view, const View* base){
+
+    // Writes view into m_packet against base, returns the number of bodies sent with a transform.
+
+    writeHeader(m_packet,replication::kViewPacket);
+    bytes::writeVarint(m_packet,view.sequence);
+    bytes::writeVarint(m_packet,base ? base->sequence : 0);
+    if (!base){
+        writeFloat(m_packet,m_config.positionPrecision);
+        writeFloat(m_packet,m_config.rotationPrecision);
+    }
+    bytes::writeVarint(m_packet,view.bodies.size());
+
+    size_t changedBodies=0;
+    uint32_t previous=0;
+    size_t cursor=0;
+    for (const QuantizedBody& body : view.bodies){
+        const QuantizedBody* old=base ? match(base->bodies,cursor,body.id) : nullptr;
+        const QuantizedBody origin=old ? *old : QuantizedBody{body.id,0,0,0};
+        const bool changed=!old || body.x!=origin.x || body.y!=origin.y || body.rotation!=origin.rotation;
+        bytes::writeVarint(m_packet,(uint64_t(body.id-previous)<<1)|(changed ? 1u : 0u));
+        if (changed){
+            bytes::writeZigzag(m_packet,body.x-origin.x);
+            bytes::writeZigzag(m_packet,body.y-origin.y);
+            bytes::writeZigzag(m_packet,body.rotation-origin.rotation);
+            changedBodies++;
+        }
+        previous=body.id;
+    }
+    return changedBodies;
+
+}
+
+void ReplicationServer::broadcast(const World& world){
+
+    ++m_sequence;
+
+    m_clients.erase(std::remove_if(m_clients.begin(),m_clients.end(),[&](const Client& c){
+        return m_sequence-c.lastHeard>m_config.timeout;
+    }),m_clients.end());
+    m_stats.clients=m_clients.size();
+
+    auto byId=[](const QuantizedBody& a,const QuantizedBody& b){ return a.id<b.id; };
+    for (Client& client : m_clients){
+        gather(world,client);
+        View& view=client.history[m_sequence%m_config.history]; // Oldest slot, reused in place
+        view.sequence=m_sequence; // Before baseline(), so an ack as old as this slot is no longer found
+        const View* base=baseline(client);
+
+        // Encode every gathered body, then drop the farthest until the datagram fits. Each retry scales the
+        // body count by how far over the packet was, so this rarely takes more than two passes.
+        size_t keep=m_gathered.size();
+        size_t changedBodies=0;
+        for (;;){
+            view.bodies.assign(m_gathered.begin(),m_gathered.begin()+keep);
+            std::sort(view.bodies.begin(),view.bodies.end(),byId);
+            changedBodies=encode(view,base);
+            if (m_packet.size()<=replication::kMaxDatagram || keep==0) break;
+            keep=std::min(keep-1,keep*replication::kMaxDatagram/m_packet.size());
+        }
+        if (keep<m_gathered.size()) m_stats.truncatedViews++;
+        if (!base) m_stats.absoluteViews++;
+
+        if (m_socket.send(client.endpoint,m_packet.data(),m_packet.size())){
+            m_stats.packetsSent++;
+            m_stats.bytesSent+=m_packet.size();
+            m_stats.bodiesSent+=view.bodies.size();
+            m_stats.changedBodies+=changedBodies;
+        }
+    }
+
+}
+
+// --- Client
+
+ReplicationClient::ReplicationClient(uint32_t history) : m_history(std::max<uint32_t>(1,history)) {}
+
+bool ReplicationClient::connect(const std::string& host, uint16_t port){
+    if (!resolve(host,port,m_server)) return false;
+    const bool loopback=(m_server.address>>24)==127; // Other servers need a socket on a routable interface
+    if (!m_socket.open(0,0,loopback ? kLoopbackAddress : kAnyAddress)) return false;
+    m_nonce=0;
+    sendAck();
+    return true;
+}
+
+void ReplicationClient::sendAck(){
+    writeHeader(m_packet,replication::kAckPacket);
+    writeNonce(m_packet,m_nonce);
+    bytes::writeVarint(m_packet,m_latest);
+    bytes::writeZigzag(m_packet,bytes::quantize(m_observer.x,replication::kObserverStep));
+    bytes::writeZigzag(m_packet,bytes::quantize(m_observer.y,replication::kObserverStep));
+    m_socket.send(m_server,m_packet.data(),m_packet.size());
+    m_lastAck=std::chrono::steady_clock::now();
+}
+
+bool ReplicationClient::decode(const unsigned char* data, size_t size){
+
+    // Decodes into the history slot of the new sequence. Only views newer than the latest are accepted,
+    // and a delta view needs its baseline still in the history.
+
+    const unsigned char* cursor=data;
+    const unsigned char* end=data+size;
+    uint64_t sequence, baseSequence, count;
+    if (!readHeader(cursor,end,replication::kViewPacket) || !bytes::readVarint(cursor,end,sequence) ||
+        !bytes::readVarint(cursor,end,baseSequence) || sequence<=m_latest || baseSequence>=sequence) return false;
+
+    const size_t slots=m_history.size();
+    const View* base=nullptr;
+    if (baseSequence!=0){
+        base=&m_history[baseSequence%slots];
+        if (base->sequence!=baseSequence || sequence-baseSequence>=slots) return false; // Baseline gone, or about to be overwritten
+    } else {
+        if (!readFloat(cursor,end,m_positionPrecision) || !readFloat(cursor,end,m_rotationPrecision)) return false;
+    }
+    if (m_positionPrecision<=0.0f || m_rotationPrecision<=0.0f) return false; // No absolute view seen yet
+    if (!bytes::readVarint(cursor,end,count) || count>size) return false; // Every body takes at least a byte
+
+    View& view=m_history[sequence%slots];
+    std::vector<QuantizedBody> bodies; // Decoded aside, so a truncated datagram leaves the history intact
+    bodies.reserve(count);
+    uint32_t id=0;
+    size_t index=0;
+    for (uint64_t i=0;i<count;++i){
+        uint64_t key;
+        if (!bytes::readVarint(cursor,end,key)) return false;
+        id+=static_cast<uint32_t>(key>>1);
+        const QuantizedBody* old=base ? match(base->bodies,index,id) : nullptr;
+        QuantizedBody body=old ? *old : QuantizedBody{id,0,0,0};
+        if (key&1){
+            int64_t dx, dy, dr;
+            if (!bytes::readZigzag(cursor,end,dx) || !bytes::readZigzag(cursor,end,dy) || !bytes::readZigzag(cursor,end,dr)) return false;
+            body.x+=dx;
+            body.y+=dy;
+            body.rotation+=dr;
+        } else if (!old){
+            return false; // Unchanged against a baseline that does not hold it
+        }
+        bodies.push_back(body);
+    }
+
+    view.sequence=static_cast<uint32_t>(sequence);
+    view.bodies.swap(bodies);
+    m_latest=view.sequence;
+
+    m_bodies.clear();
+    for (const QuantizedBody& body : view.bodies){
+        m_bodies.push_back(ReplicatedBody{body.id,
+                                          Vec2(static_cast<Real>(bytes::dequantize(body.x,m_positionPrecision)),
+                                               static_cast<Real>(bytes::dequantize(body.y,m_positionPrecision))),
+                                          static_cast<Real>(bytes::dequantize(body.rotation,m_rotationPrecision))});
+    }
+    return true;
+
+}
+
+bool ReplicationClient::poll(){
+
+    unsigned char buffer[replication::kMaxDatagram];
+    Endpoint from;
+    bool changed=false;
+    bool challenged=false;
+    for (int size;(size=m_socket.receive(buffer,sizeof(buffer),from))>=0;){
+        m_bytesReceived+=size;
+        const unsigned char* cursor=buffer;
+        uint32_t nonce;
+        if (from==m_server && readHeader(cursor,buffer+size,replication::kChallengePacket) && readNonce(cursor,buffer+size,nonce)){
+            m_nonce=nonce;
+            challenged=true;
+            continue;
+        }
+        if (from!=m_server || !decode(buffer,size)){
+            m_dropped++;
+            continue;
+        }
+        changed=true;
+    }
+    // A challenge is answered at once rather than after the retry interval
+    if (changed || challenged || std::chrono::steady_clock::now()-m_lastAck>=std::chrono::milliseconds(replication::kAckRetryMs)) sendAck();
+    return changed;
+
+}
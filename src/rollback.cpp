@@ -0,0 +1,91 @@
+// rollback.cpp
+// Preallocated ring of World states ( see core/Rollback.hpp ).
+
+#include "core/Rollback.hpp"
+#include <algorithm>
+
+RollbackBuffer::RollbackBuffer(size_t frames, size_t maxBodies, size_t maxPairs)
+    : m_maxBodies(maxBodies), m_maxPairs(maxPairs), m_slots(std::max<size_t>(1,frames)) {
+    m_ids.resize(m_slots.size()*m_maxBodies);
+    m_states.resize(m_slots.size()*m_maxBodies);
+    m_pairs.resize(m_slots.size()*m_maxPairs);
+}
+
+size_t RollbackBuffer::frameBytes() const{
+    return sizeof(Slot)+m_maxBodies*(sizeof(uint32_t)+sizeof(BodyState))+m_maxPairs*sizeof(std::pair<uint32_t,uint32_t>);
+}
+
+bool RollbackBuffer::contains(uint32_t frame) const{
+    const Slot& slot=m_slots[frame%m_slots.size()];
+    return slot.valid && slot.frame==frame;
+}
+
+bool RollbackBuffer::save(const World& world, uint32_t frame){
+
+    const std::vector<RigidBody>& bodies=world.m_bodies;
+    const size_t pairs=world.m_touching.size()+world.m_sensorOverlaps.size();
+    if (bodies.size()>m_maxBodies || pairs>m_maxPairs) return false;
+
+    const size_t index=frame%m_slots.size();
+    Slot& slot=m_slots[index];
+    uint32_t* ids=m_ids.data()+index*m_maxBodies;
+    BodyState* states=m_states.data()+index*m_maxBodies;
+    for (size_t i=0;i<bodies.size();++i){
+        const RigidBody& body=bodies[i];
+        ids[i]=body.id;
+        states[i]=BodyState{body.position,body.linearVelocity,body.rotation,body.angularVelocity};
+    }
+
+    auto* out=m_pairs.data()+index*m_maxPairs;
+    out=std::copy(world.m_touching.begin(),world.m_touching.end(),out);
+    std::copy(world.m_sensorOverlaps.begin(),world.m_sensorOverlaps.end(),out);
+
+    slot.frame=frame;
+    slot.valid=true;
+    slot.bodyCount=static_cast<uint32_t>(bodies.size());
+    slot.touchingCount=static_cast<uint32_t>(world.m_touching.size());
+    slot.sensorCount=static_cast<uint32_t>(world.m_sensorOverlaps.size());
+    slot.lastStateHash=world.m_lastStateHash;
+    return true;
+
+}
+
+bool RollbackBuffer::restore(World& world, uint32_t frame) const{
+
+    // Validates the body set first so a failed restore leaves the World as it was. Accelerations and forces
+    // are rebuilt by the next step, world-space vertices and the grid by refreshBroadphase().
+
+    if (!contains(frame)) return false;
+    const size_t index=frame%m_slots.size();
+    const Slot& slot=m_slots[index];
+
+    std::vector<RigidBody>& bodies=world.m_bodies;
+    const uint32_t* ids=m_ids.data()+index*m_maxBodies;
+    if (bodies.size()!=slot.bodyCount) return false;
+    for (size_t i=0;i<bodies.size();++i){
+        if (bodies[i].id!=ids[i]) return false;
+    }
+
+    const BodyState* states=m_states.data()+index*m_maxBodies;
+    for (size_t i=0;i<bodies.size();++i){
+        RigidBody& body=bodies[i];
+        const BodyState& state=states[i];
+        body.position=state.position;
+        body.linearVelocity=state.linearVelocity;
+        body.rotation=state.rotation;
+        body.angularVelocity=state.angularVelocity;
+        body.update=true;
+    }
+
+    const auto* pairs=m_pairs.data()+index*m_maxPairs;
+    world.m_touching.assign(pairs,pairs+slot.touchingCount);
+    world.m_sensorOverlaps.assign(pairs+slot.touchingCount,pairs+slot.touchingCount+slot.sensorCount);
+    world.m_lastStateHash=slot.lastStateHash;
+    world.m_sensorEvents.clear();
+    world.m_contactEvents.begin.clear();
+    world.m_contactEvents.end.clear();
+    world.m_contactEvents.impacts.clear();
+    world.refreshBroadphase();
+    return true;
+
+}
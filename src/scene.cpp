@@ -0,0 +1,366 @@
+// scene.cpp
+// Text and binary scene loading ( formats documented in io/Scene.hpp ).
+
+#include "io/Scene.hpp"
+#include "io/MappedFile.hpp"
+#include "core/World.hpp"
+#include "math/Math.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+namespace scene {
+
+namespace {
+
+void setError(std::string* error,const std::string& message){
+    if (error) *error=message;
+}
+
+size_t align8(size_t n){
+    return (n+7) & ~size_t(7);
+}
+
+void recentre(Vec2* v,size_t count){
+
+    // Shifts a polygon so its area centroid sits on the origin ( the body's COM ).
+
+    Real area=0.0f;
+    Vec2 centroid(0.0f,0.0f);
+    for (size_t i=0;i<count;++i){
+        const Vec2& a=v[i];
+        const Vec2& b=v[(i+1)%count];
+        Real cross=a.x*b.y-a.y*b.x;
+        area+=cross;
+        centroid+=(a+b)*cross;
+    }
+    if (std::abs(area)<1e-12f) return;
+    centroid=centroid/(3.0f*area);
+    for (size_t i=0;i<count;++i) v[i]-=centroid;
+
+}
+
+bool isConvex(const Vec2* v,size_t count){
+
+    // Every turn goes the same way and the edges wind around exactly once, which also rules out
+    // self-intersecting stars. Collinear vertices are allowed, zero area outlines are not.
+
+    Real sign=0.0f;
+    Real turning=0.0f;
+    for (size_t i=0;i<count;++i){
+        const Vec2 e0=v[(i+1)%count]-v[i];
+        const Vec2 e1=v[(i+2)%count]-v[(i+1)%count];
+        const Real cross=e0.x*e1.y-e0.y*e1.x;
+        if (cross!=0.0f){
+            if (sign*cross<0.0f) return false;
+            sign=cross;
+        }
+        turning+=std::atan2(cross,e0.x*e1.x+e0.y*e1.y);
+    }
+    return sign!=0.0f && std::abs(std::abs(turning)-2.0f*vecMath::pi)<1e-3f;
+
+}
+
+bool parseColour(const std::string& value,Colour& colour){
+    return std::sscanf(value.c_str(),"%f,%f,%f",&colour.r,&colour.g,&colour.b)==3;
+}
+
+bool instantiateRaw(const Vec2* vertices,size_t vertexCount,
+                    const SceneShape* shapes,size_t shapeCount,
+                    const MaterialDef* materials,size_t materialCount,
+                    const BodyInstance* instances,size_t instanceCount,
+                    World& world,std::string* error){
+
+    // Turns every instance into a BodyDef pointing at its shape's vertices ( in the scene or the
+    // mapped file ), then creates the whole batch at once so bodies are constructed in place.
+
+    for (size_t s=0;s<shapeCount;++s){
+        const SceneShape& def=shapes[s];
+        if (def.vertexCount<3 || uint64_t(def.firstVertex)+def.vertexCount>vertexCount){
+            setError(error,"shape "+std::to_string(s)+" has an invalid vertex range");
+            return false;
+        }
+        if (!isConvex(vertices+def.firstVertex,def.vertexCount)){ // Binary scenes skip the text parser's check
+            setError(error,"shape "+std::to_string(s)+" is not convex");
+            return false;
+        }
+    }
+
+    std::vector<BodyDef> defs(instanceCount);
+
+    for (size_t i=0;i<instanceCount;++i){
+        const BodyInstance& inst=instances[i];
+        if (inst.shape>=shapeCount || inst.material>=materialCount){
+            setError(error,"instance "+std::to_string(i)+" references an unknown shape or material");
+            return false;
+        }
+
+        const SceneShape& shape=shapes[inst.shape];
+        const MaterialDef& material=materials[inst.material];
+        BodyDef& def=defs[i];
+
+        def.vertices=vertices+shape.firstVertex;
+        def.vertexCount=shape.vertexCount;
+        def.shape=static_cast<ShapeType>(shape.shape);
+        def.position=inst.position;
+        def.rotation=inst.rotation;
+        def.linearVelocity=inst.linearVelocity;
+        def.angularVelocity=inst.angularVelocity;
+        def.colour=inst.colour;
+        def.mass=inst.mass;
+        def.density=material.density;
+        def.staticFriction=material.staticFriction;
+        def.dynamicFriction=material.dynamicFriction;
+        def.restitution=material.restitution;
+        def.isStatic=inst.isStatic!=0;
+        def.categoryBits=inst.categoryBits;
+        def.maskBits=inst.maskBits;
+        def.groupIndex=inst.groupIndex;
+        def.isSensor=inst.isSensor!=0;
+    }
+
+    world.createBodies(defs);
+    return true;
+
+}
+
+} // namespace
+
+bool parseText(std::istream& in,Scene& out,std::string* error){
+
+    // Parses declarations one line at a time. Names are only needed while parsing,
+    // the resulting Scene refers to shapes and materials by index.
+
+    std::unordered_map<std::string,uint32_t> shapeIds;
+    std::unordered_map<std::string,uint32_t> materialIds;
+
+    std::string line;
+    int lineNumber=0;
+
+    auto fail=[&](const std::string& message){
+        setError(error,"line "+std::to_string(lineNumber)+": "+message);
+        return false;
+    };
+
+    while (std::getline(in,line)){
+        ++lineNumber;
+
+        size_t comment=line.find('#');
+        if (comment!=std::string::npos) line.erase(comment);
+
+        std::istringstream tokens(line);
+        std::string keyword;
+        if (!(tokens >> keyword)) continue; // Blank line
+
+        if (keyword=="shape"){
+            std::string name,kind;
+            if (!(tokens >> name >> kind)) return fail("expected 'shape <name> <kind> ...'");
+
+            SceneShape def;
+            def.firstVertex=static_cast<uint32_t>(out.vertices.size());
+
+            if (kind=="box"){
+                Real w,h;
+                if (!(tokens >> w >> h)) return fail("box needs <width> <height>");
+                Real hw=w*0.5f, hh=h*0.5f;
+                out.vertices.insert(out.vertices.end(),{Vec2(-hw,-hh),Vec2(hw,-hh),Vec2(hw,hh),Vec2(-hw,hh)});
+                def.shape=Rectangle;
+                def.sides=4;
+            } else if (kind=="ngon"){
+                int sides;
+                Real radius;
+                if (!(tokens >> sides >> radius) || sides<3) return fail("ngon needs <sides >= 3> <radius>");
+                std::vector<Vec2> verts=generateRegularPolygon(sides,radius);
+                out.vertices.insert(out.vertices.end(),verts.begin(),verts.end());
+                def.sides=sides;
+            } else if (kind=="poly"){
+                Real x,y;
+                while (tokens >> x >> y) out.vertices.push_back(Vec2(x,y));
+                size_t count=out.vertices.size()-def.firstVertex;
+                if (count<3) return fail("poly needs at least 3 vertices");
+                if (!isConvex(out.vertices.data()+def.firstVertex,count)) return fail("poly must be convex");
+                recentre(out.vertices.data()+def.firstVertex,count);
+                def.sides=static_cast<int32_t>(count);
+            } else {
+                return fail("unknown shape kind '"+kind+"'");
+            }
+
+            def.vertexCount=static_cast<uint32_t>(out.vertices.size()-def.firstVertex);
+            shapeIds[name]=static_cast<uint32_t>(out.shapes.size());
+            out.shapes.push_back(def);
+
+        } else if (keyword=="material"){
+            std::string name;
+            MaterialDef def;
+            if (!(tokens >> name >> def.density >> def.staticFriction >> def.dynamicFriction >> def.restitution)){
+                return fail("expected 'material <name> <density> <staticFriction> <dynamicFriction> <restitution>'");
+            }
+            materialIds[name]=static_cast<uint32_t>(out.materials.size());
+            out.materials.push_back(def);
+
+        } else if (keyword=="bodies"){
+            size_t count;
+            if (!(tokens >> count)) return fail("expected 'bodies <count>'");
+            out.instances.reserve(out.instances.size()+count);
+
+        } else if (keyword=="body"){
+            std::string shapeName,materialName;
+            BodyInstance inst;
+            if (!(tokens >> shapeName >> materialName >> inst.position.x >> inst.position.y)){
+                return fail("expected 'body <shape> <material> <x> <y> [key=value ...]'");
+            }
+
+            auto shapeIt=shapeIds.find(shapeName);
+            if (shapeIt==shapeIds.end()) return fail("unknown shape '"+shapeName+"'");
+            auto materialIt=materialIds.find(materialName);
+            if (materialIt==materialIds.end()) return fail("unknown material '"+materialName+"'");
+            inst.shape=shapeIt->second;
+            inst.material=materialIt->second;
+
+            std::string option;
+            while (tokens >> option){
+                size_t eq=option.find('=');
+                if (eq==std::string::npos) return fail("expected key=value, got '"+option+"'");
+                std::string key=option.substr(0,eq);
+                std::string value=option.substr(eq+1);
+                bool ok=true;
+                try {
+                    if (key=="rot") inst.rotation=std::stod(value);
+                    else if (key=="vx") inst.linearVelocity.x=std::stod(value);
+                    else if (key=="vy") inst.linearVelocity.y=std::stod(value);
+                    else if (key=="w") inst.angularVelocity=std::stod(value);
+                    else if (key=="mass") inst.mass=std::stod(value);
+                    else if (key=="static") inst.isStatic=std::stoi(value)!=0;
+                    else if (key=="sensor") inst.isSensor=std::stoi(value)!=0;
+                    else if (key=="colour") ok=parseColour(value,inst.colour);
+                    else if (key=="category") inst.categoryBits=static_cast<uint16_t>(std::stoul(value,nullptr,0));
+                    else if (key=="mask") inst.maskBits=static_cast<uint16_t>(std::stoul(value,nullptr,0));
+                    else if (key=="group") inst.groupIndex=static_cast<int16_t>(std::stoi(value));
+                    else return fail("unknown body key '"+key+"'");
+                } catch (const std::exception&) {
+                    ok=false;
+                }
+                if (!ok) return fail("bad value for '"+key+"'");
+            }
+            out.instances.push_back(inst);
+
+        } else {
+            return fail("unknown keyword '"+keyword+"'");
+        }
+    }
+
+    return true;
+
+}
+
+bool loadText(const std::string& path,Scene& out,std::string* error){
+    std::ifstream in(path);
+    if (!in){
+        setError(error,"cannot open "+path);
+        return false;
+    }
+    return parseText(in,out,error);
+}
+
+bool saveBinary(const Scene& scene,const std::string& path){
+
+    SceneHeader header;
+    header.vertexCount=scene.vertices.size();
+    header.shapeCount=scene.shapes.size();
+    header.materialCount=scene.materials.size();
+    header.instanceCount=scene.instances.size();
+    header.vertexOffset=align8(sizeof(SceneHeader));
+    header.shapeOffset=align8(header.vertexOffset+header.vertexCount*sizeof(Vec2));
+    header.materialOffset=align8(header.shapeOffset+header.shapeCount*sizeof(SceneShape));
+    header.instanceOffset=align8(header.materialOffset+header.materialCount*sizeof(MaterialDef));
+
+    std::vector<unsigned char> bytes(header.instanceOffset+header.instanceCount*sizeof(BodyInstance),0);
+    std::memcpy(bytes.data(),&header,sizeof(header));
+    if (header.vertexCount) std::memcpy(bytes.data()+header.vertexOffset,scene.vertices.data(),header.vertexCount*sizeof(Vec2));
+    if (header.shapeCount) std::memcpy(bytes.data()+header.shapeOffset,scene.shapes.data(),header.shapeCount*sizeof(SceneShape));
+    if (header.materialCount) std::memcpy(bytes.data()+header.materialOffset,scene.materials.data(),header.materialCount*sizeof(MaterialDef));
+    if (header.instanceCount) std::memcpy(bytes.data()+header.instanceOffset,scene.instances.data(),header.instanceCount*sizeof(BodyInstance));
+
+    std::FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file) return false;
+    bool ok=std::fwrite(bytes.data(),1,bytes.size(),file)==bytes.size();
+    return (std::fclose(file)==0) && ok;
+
+}
+
+bool instantiate(const Scene& scene,World& world,std::string* error){
+    return instantiateRaw(scene.vertices.data(),scene.vertices.size(),
+                          scene.shapes.data(),scene.shapes.size(),
+                          scene.materials.data(),scene.materials.size(),
+                          scene.instances.data(),scene.instances.size(),
+                          world,error);
+}
+
+bool loadBinary(const std::string& path,World& world,std::string* error){
+
+    MappedFile file;
+    if (!file.open(path)){
+        setError(error,"cannot map "+path);
+        return false;
+    }
+
+    SceneHeader header;
+    if (file.size()<sizeof(header)){
+        setError(error,path+" is too small to be a scene");
+        return false;
+    }
+    std::memcpy(&header,file.data(),sizeof(header));
+    if (header.magic!=kSceneMagic || header.version!=kSceneVersion){
+        setError(error,path+" is not a binary scene of version "+std::to_string(kSceneVersion));
+        return false;
+    }
+    if (header.scalarSize!=sizeof(Real)){
+        setError(error,path+" was baked with "+std::to_string(header.scalarSize*8)+" bit scalars, this build uses "+
+                 std::to_string(sizeof(Real)*8));
+        return false;
+    }
+
+    // Divides instead of multiplying, so huge counts or offsets in a damaged file cannot wrap the check
+    auto fits=[&](uint64_t offset,uint64_t count,size_t elementSize){
+        return offset%8==0 && offset<=file.size() && count<=(file.size()-offset)/elementSize;
+    };
+    if (!fits(header.vertexOffset,header.vertexCount,sizeof(Vec2)) ||
+        !fits(header.shapeOffset,header.shapeCount,sizeof(SceneShape)) ||
+        !fits(header.materialOffset,header.materialCount,sizeof(MaterialDef)) ||
+        !fits(header.instanceOffset,header.instanceCount,sizeof(BodyInstance))){
+        setError(error,path+" is truncated");
+        return false;
+    }
+
+    const unsigned char* base=file.data();
+    return instantiateRaw(reinterpret_cast<const Vec2*>(base+header.vertexOffset),header.vertexCount,
+                          reinterpret_cast<const SceneShape*>(base+header.shapeOffset),header.shapeCount,
+                          reinterpret_cast<const MaterialDef*>(base+header.materialOffset),header.materialCount,
+                          reinterpret_cast<const BodyInstance*>(base+header.instanceOffset),header.instanceCount,
+                          world,error);
+
+}
+
+bool loadScene(const std::string& path,World& world,std::string* error){
+
+    uint32_t magic=0;
+    if (std::FILE* file=std::fopen(path.c_str(),"rb")){
+        if (std::fread(&magic,sizeof(magic),1,file)!=1) magic=0;
+        std::fclose(file);
+    } else {
+        setError(error,"cannot open "+path);
+        return false;
+    }
+
+    if (magic==kSceneMagic) return loadBinary(path,world,error);
+
+    Scene parsed;
+    if (!loadText(path,parsed,error)) return false;
+    return instantiate(parsed,world,error);
+
+}
+
+} // namespace scene
@@ -0,0 +1,287 @@
+// snapshot.cpp
+// Writes and restores World snapshots ( format documented in io/Snapshot.hpp ).
+
+#include "io/Snapshot.hpp"
+#include "io/MappedFile.hpp"
+#include "core/World.hpp"
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace snapshot {
+
+static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "SnapshotHeader must be memcpy-able");
+static_assert(std::is_trivially_copyable<BodyRecord>::value, "BodyRecord must be memcpy-able");
+static_assert(sizeof(Vec2)==2*sizeof(Real), "Vec2 must be two tightly packed scalars");
+static_assert(sizeof(SnapshotHeader)%8==0 && sizeof(BodyRecord)%8==0, "Sections must stay 8 byte aligned");
+
+BodyRecord makeRecord(const RigidBody& body,std::vector<Vec2>& vertices,std::vector<Vec2>& transformed,std::vector<uint32_t>& children){
+
+    // Flattens body into a record. The body's vertex lists are appended to the shared vertex
+    // sections and referenced by offset, so records stay fixed size.
+
+    BodyRecord r{};
+    r.shape=static_cast<int32_t>(body.shape);
+    r.sides=body.sides;
+    r.radius=body.radius;
+    r.force=body.force;
+    r.position=body.position;
+    r.rotation=body.rotation;
+    r.linearVelocity=body.linearVelocity;
+    r.linearAcceleration=body.linearAcceleration;
+    r.angularVelocity=body.angularVelocity;
+    r.angularAcceleration=body.angularAcceleration;
+    r.colour=body.colour;
+    r.inertia=body.inertia;
+    r.inverseInertia=body.inverseInertia;
+    r.staticFriction=body.staticFriction;
+    r.dynamicFriction=body.dynamicFriction;
+    r.density=body.density;
+    r.mass=body.mass;
+    r.inverseMass=body.inverseMass;
+    r.restitution=body.restitution;
+    r.area=body.area;
+    r.isStatic=body.isStatic;
+    r.isBullet=body.isBullet;
+    r.isSensor=body.isSensor;
+    r.categoryBits=body.categoryBits;
+    r.maskBits=body.maskBits;
+    r.groupIndex=body.groupIndex;
+    r.update=body.update;
+    r.id=body.id;
+
+    r.firstVertex=vertices.size();
+    r.vertexCount=static_cast<uint32_t>(body.vertices.size());
+    vertices.insert(vertices.end(),body.vertices.begin(),body.vertices.end());
+
+    r.firstTransformed=transformed.size();
+    r.transformedCount=static_cast<uint32_t>(body.transformedVertices.size());
+    transformed.insert(transformed.end(),body.transformedVertices.begin(),body.transformedVertices.end());
+
+    r.firstChild=children.size();
+    r.childCount=static_cast<uint32_t>(body.children.size());
+    for (const ChildShape& child : body.children) children.push_back(child.count);
+
+    return r;
+
+}
+
+void restoreRecord(const BodyRecord& r,const Vec2* vertices,const Vec2* transformed,const uint32_t* children,RigidBody& body){
+
+    // Inverse of makeRecord(). Vertex pointers are the starts of the snapshot's vertex sections.
+
+    body.shape=static_cast<ShapeType>(r.shape);
+    body.sides=r.sides;
+    body.radius=r.radius;
+    body.force=r.force;
+    body.position=r.position;
+    body.rotation=r.rotation;
+    body.linearVelocity=r.linearVelocity;
+    body.linearAcceleration=r.linearAcceleration;
+    body.angularVelocity=r.angularVelocity;
+    body.angularAcceleration=r.angularAcceleration;
+    body.colour=r.colour;
+    body.inertia=r.inertia;
+    body.inverseInertia=r.inverseInertia;
+    body.staticFriction=r.staticFriction;
+    body.dynamicFriction=r.dynamicFriction;
+    body.density=r.density;
+    body.mass=r.mass;
+    body.inverseMass=r.inverseMass;
+    body.restitution=r.restitution;
+    body.area=r.area;
+    body.isStatic=r.isStatic!=0;
+    body.isBullet=r.isBullet!=0;
+    body.isSensor=r.isSensor!=0;
+    body.categoryBits=r.categoryBits;
+    body.maskBits=r.maskBits;
+    body.groupIndex=r.groupIndex;
+    body.update=r.update!=0;
+    body.id=r.id;
+
+    const Vec2* v=vertices+r.firstVertex;
+    body.vertices.assign(v,v+r.vertexCount);
+    const Vec2* t=transformed+r.firstTransformed;
+    body.transformedVertices.assign(t,t+r.transformedCount);
+    setChildShapes(body,children+r.firstChild,r.childCount); // Same counts, so the same tree
+
+}
+
+bool SnapshotView::open(const unsigned char* data,size_t size){
+
+    // Validates that data holds a complete snapshot written by this build, then points the
+    // section accessors straight into it. No bytes are copied.
+
+    m_header=nullptr;
+    if (!data || size<sizeof(SnapshotHeader)) return false;
+
+    const auto* header=reinterpret_cast<const SnapshotHeader*>(data);
+    if (header->magic!=kSnapshotMagic || header->version!=kSnapshotVersion) return false;
+    if (header->endianTag!=kEndianTag || header->scalarSize!=sizeof(Real)) return false;
+    if (header->headerSize!=sizeof(SnapshotHeader) || header->bodyRecordSize!=sizeof(BodyRecord)) return false;
+    if (header->edgeRecordSize!=sizeof(EdgeShape)) return false;
+
+    // Every count is compared against what is left of the buffer in elements, never multiplied first, so
+    // crafted counts cannot wrap the size arithmetic
+    const unsigned char* cursor=data+sizeof(SnapshotHeader);
+    size_t remaining=size-sizeof(SnapshotHeader);
+    auto take=[&](uint64_t count,size_t elementSize,auto*& section){
+        if (count>remaining/elementSize) return false; // Truncated
+        section=reinterpret_cast<std::remove_reference_t<decltype(section)>>(cursor);
+        cursor+=count*elementSize;
+        remaining-=count*elementSize;
+        return true;
+    };
+    if (!take(header->bodyCount,sizeof(BodyRecord),m_bodies)) return false;
+    if (!take(header->vertexCount,sizeof(Vec2),m_vertices)) return false;
+    if (!take(header->transformedCount,sizeof(Vec2),m_transformed)) return false;
+    if (!take(header->edgeCount,sizeof(EdgeShape),m_edges)) return false;
+    if (!take(header->childCount,sizeof(uint32_t),m_children)) return false;
+    if (header->touchingCount>remaining/(2*sizeof(uint32_t))) return false;
+    m_touching=reinterpret_cast<const uint32_t*>(cursor);
+
+    // Reject records pointing outside the vertex sections
+    for (uint64_t i=0;i<header->bodyCount;++i){
+        const BodyRecord& r=m_bodies[i];
+        if (r.firstVertex>header->vertexCount || r.vertexCount>header->vertexCount-r.firstVertex) return false;
+        if (r.firstTransformed>header->transformedCount || r.transformedCount>header->transformedCount-r.firstTransformed) return false;
+        if (r.firstChild>header->childCount || r.childCount>header->childCount-r.firstChild) return false;
+        uint64_t pieceVertices=0;
+        for (uint32_t c=0;c<r.childCount;++c) pieceVertices+=m_children[r.firstChild+c];
+        if (r.childCount && pieceVertices!=r.vertexCount) return false; // Pieces must cover the vertices exactly
+    }
+
+    m_header=header;
+    return true;
+
+}
+
+} // namespace snapshot
+
+void World::writeSnapshot(std::vector<unsigned char>& out) const{
+
+    // Serializes the world into out ( overwriting it ), in one contiguous buffer.
+
+    using namespace snapshot;
+
+    std::vector<BodyRecord> records;
+    std::vector<Vec2> vertices;
+    std::vector<Vec2> transformed;
+    std::vector<uint32_t> children;
+    records.reserve(m_bodies.size());
+    vertices.reserve(m_bodies.size()*4);
+    transformed.reserve(m_bodies.size()*4);
+
+    for (const RigidBody& body : m_bodies){
+        records.push_back(makeRecord(body,vertices,transformed,children));
+    }
+
+    SnapshotHeader header;
+    header.headerSize=sizeof(SnapshotHeader);
+    header.bodyRecordSize=sizeof(BodyRecord);
+    header.bodyCount=records.size();
+    header.vertexCount=vertices.size();
+    header.transformedCount=transformed.size();
+    header.gravityX=gravity.x;
+    header.gravityY=gravity.y;
+    header.yBounds=m_yBounds;
+    header.solverIterations=solverIterations;
+    header.stats=m_stats;
+    header.nextBodyId=m_nextId;
+    header.edgeCount=m_static->edgeCount();
+    header.edgeRecordSize=sizeof(EdgeShape);
+    header.nextChainId=m_nextChainId;
+    header.childCount=children.size();
+    header.impactThreshold=m_impactThreshold;
+    header.touchingCount=m_touching.size();
+    header.contactEvents=m_contactEventsEnabled ? 1 : 0;
+    header.lastStateHash=m_lastStateHash;
+    header.speculative=m_speculative ? 1 : 0;
+    header.deterministic=m_deterministic ? 1 : 0;
+
+    std::vector<uint32_t> touching;
+    touching.reserve(m_touching.size()*2);
+    for (const auto& pair : m_touching){
+        touching.push_back(pair.first);
+        touching.push_back(pair.second);
+    }
+
+    const size_t recordBytes=records.size()*sizeof(BodyRecord);
+    const size_t vertexBytes=vertices.size()*sizeof(Vec2);
+    const size_t transformedBytes=transformed.size()*sizeof(Vec2);
+    const size_t edgeBytes=m_static->edgeCount()*sizeof(EdgeShape);
+    const size_t childBytes=children.size()*sizeof(uint32_t);
+    const size_t touchingBytes=touching.size()*sizeof(uint32_t);
+
+    out.resize(sizeof(SnapshotHeader)+recordBytes+vertexBytes+transformedBytes+edgeBytes+childBytes+touchingBytes);
+    unsigned char* cursor=out.data();
+    std::memcpy(cursor,&header,sizeof(SnapshotHeader)); cursor+=sizeof(SnapshotHeader);
+    if (recordBytes) { std::memcpy(cursor,records.data(),recordBytes); cursor+=recordBytes; }
+    if (vertexBytes) { std::memcpy(cursor,vertices.data(),vertexBytes); cursor+=vertexBytes; }
+    if (transformedBytes) { std::memcpy(cursor,transformed.data(),transformedBytes); cursor+=transformedBytes; }
+    if (edgeBytes) { std::memcpy(cursor,m_static->edges(),edgeBytes); cursor+=edgeBytes; }
+    if (childBytes) { std::memcpy(cursor,children.data(),childBytes); cursor+=childBytes; }
+    if (touchingBytes) { std::memcpy(cursor,touching.data(),touchingBytes); }
+
+}
+
+bool World::saveSnapshot(const std::string& path) const{
+
+    std::vector<unsigned char> bytes;
+    writeSnapshot(bytes);
+
+    std::FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file) return false;
+    bool ok=std::fwrite(bytes.data(),1,bytes.size(),file)==bytes.size();
+    ok=(std::fclose(file)==0) && ok;
+    return ok;
+
+}
+
+bool World::restoreSnapshot(const snapshot::SnapshotView& view){
+
+    // Replaces all bodies and solver state with the snapshot's contents.
+    // Bodies are rebuilt in a single pass with one reservation.
+
+    const snapshot::SnapshotHeader& header=view.header();
+
+    m_bodies.clear();
+    m_bodies.resize(header.bodyCount);
+    for (uint64_t i=0;i<header.bodyCount;++i){
+        snapshot::restoreRecord(view.bodies()[i],view.vertices(),view.transformedVertices(),view.children(),m_bodies[i]);
+    }
+
+    gravity=Vec2(header.gravityX,header.gravityY);
+    m_yBounds=header.yBounds;
+    solverIterations=header.solverIterations;
+    m_stats=header.stats;
+    m_nextId=header.nextBodyId;
+    rebuildStatic(std::vector<EdgeShape>(view.edges(),view.edges()+header.edgeCount)); // Already in leaf order, rebakes the same tree
+    m_nextChainId=header.nextChainId;
+    m_impactThreshold=static_cast<Real>(header.impactThreshold);
+    m_contactEventsEnabled=header.contactEvents!=0;
+    m_lastStateHash=header.lastStateHash;
+    m_speculative=header.speculative!=0;
+    m_deterministic=header.deterministic!=0;
+    m_touching.clear();
+    for (uint64_t i=0;i<header.touchingCount;++i) m_touching.push_back({view.touching()[2*i],view.touching()[2*i+1]});
+    m_contactEvents.begin.clear();
+    m_contactEvents.end.clear();
+    m_contactEvents.impacts.clear();
+    refreshBroadphase();
+    updateSensors(false); // Overlaps at the saved pose, so the next step only reports changes
+    return true;
+
+}
+
+bool World::loadSnapshot(const std::string& path){
+
+    MappedFile file;
+    if (!file.open(path)) return false;
+
+    snapshot::SnapshotView view;
+    if (!view.open(file.data(),file.size())) return false;
+
+    return restoreSnapshot(view);
+
+}
@@ -0,0 +1,272 @@
+// static_geometry.cpp
+// Binned SAH build, bake serialization and mapped loading for StaticGeometry.
+
+#include "collision/StaticGeometry.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int kBins=16;
+constexpr uint32_t kMaxLeafSize=4;
+constexpr int kMaxDepth=48; // Past this, splits fall back to the median so the query stack cannot overflow
+constexpr uint64_t kSectionAlign=32;
+
+struct BuildItem{
+    AABB box;
+    Vec2 centre;
+    uint32_t edge;
+};
+
+AABB emptyBox(){
+    const Real inf=std::numeric_limits<Real>::infinity();
+    return AABB{Vec2(inf,inf),Vec2(-inf,-inf)};
+}
+
+void grow(AABB& box,const AABB& other){
+    box.min.x=std::min(box.min.x,other.min.x);
+    box.min.y=std::min(box.min.y,other.min.y);
+    box.max.x=std::max(box.max.x,other.max.x);
+    box.max.y=std::max(box.max.y,other.max.y);
+}
+
+Real perimeter(const AABB& box){ // 2D stand-in for surface area
+    if (box.max.x<box.min.x) return 0.0f;
+    return 2.0f*((box.max.x-box.min.x)+(box.max.y-box.min.y));
+}
+
+Real axisOf(const Vec2& v,int axis){ return axis==0 ? v.x : v.y; }
+
+uint64_t alignUp(uint64_t value){ return (value+kSectionAlign-1)&~(kSectionAlign-1); }
+
+uint32_t buildSubtree(std::vector<BuildItem>& items,std::vector<BVHNode>& nodes,uint32_t begin,uint32_t end,int depth){
+
+    // Builds the subtree over items[begin, end) and returns its root. Nodes are appended depth first,
+    // so the left child is always the node right after its parent.
+    // Each split tries kBins buckets on both axes and keeps the cheapest, or makes a leaf when splitting
+    // costs more than testing every edge. Partitioning is stable, so a given input always bakes the same tree.
+
+    const uint32_t node=static_cast<uint32_t>(nodes.size());
+    nodes.push_back(BVHNode{});
+
+    AABB bounds=emptyBox();
+    AABB centres=emptyBox();
+    for (uint32_t i=begin;i<end;++i){
+        grow(bounds,items[i].box);
+        grow(centres,AABB{items[i].centre,items[i].centre});
+    }
+
+    const uint32_t n=end-begin;
+    if (n<=kMaxLeafSize){
+        nodes[node]=BVHNode{bounds,begin,n};
+        return node;
+    }
+
+    int bestAxis=-1;
+    int bestSplit=0;
+    Real bestCost=std::numeric_limits<Real>::infinity();
+
+    for (int axis=0;axis<2 && depth<kMaxDepth;++axis){
+        const Real lo=axisOf(centres.min,axis);
+        const Real extent=axisOf(centres.max,axis)-lo;
+        if (extent<=0.0f) continue;
+
+        AABB binBox[kBins];
+        uint32_t binCount[kBins]={};
+        for (int b=0;b<kBins;++b) binBox[b]=emptyBox();
+        const Real scale=kBins/extent;
+        for (uint32_t i=begin;i<end;++i){
+            int b=std::min(kBins-1,static_cast<int>((axisOf(items[i].centre,axis)-lo)*scale));
+            binCount[b]++;
+            grow(binBox[b],items[i].box);
+        }
+
+        // Sweep from the right for suffix areas, then from the left to price each split
+        Real rightArea[kBins];
+        uint32_t rightCount[kBins];
+        AABB acc=emptyBox();
+        uint32_t accCount=0;
+        for (int b=kBins-1;b>0;--b){
+            grow(acc,binBox[b]);
+            accCount+=binCount[b];
+            rightArea[b]=perimeter(acc);
+            rightCount[b]=accCount;
+        }
+        acc=emptyBox();
+        accCount=0;
+        for (int split=1;split<kBins;++split){
+            grow(acc,binBox[split-1]);
+            accCount+=binCount[split-1];
+            if (accCount==0 || rightCount[split]==0) continue;
+            Real cost=accCount*perimeter(acc)+rightCount[split]*rightArea[split];
+            if (cost<bestCost){ bestCost=cost; bestAxis=axis; bestSplit=split; }
+        }
+    }
+
+    auto first=items.begin()+begin;
+    auto last=items.begin()+end;
+    auto middle=first;
+
+    if (bestAxis>=0){
+        if (bestCost>=n*perimeter(bounds) && n<=2*kMaxLeafSize){ // Splitting does not pay off
+            nodes[node]=BVHNode{bounds,begin,n};
+            return node;
+        }
+        const Real lo=axisOf(centres.min,bestAxis);
+        const Real scale=kBins/(axisOf(centres.max,bestAxis)-lo);
+        middle=std::stable_partition(first,last,[&](const BuildItem& item){
+            return std::min(kBins-1,static_cast<int>((axisOf(item.centre,bestAxis)-lo)*scale))<bestSplit;
+        });
+    } else {
+        // Coincident centres or too deep: median split along the longer axis
+        const int axis=(centres.max.x-centres.min.x)>=(centres.max.y-centres.min.y) ? 0 : 1;
+        std::stable_sort(first,last,[&](const BuildItem& a,const BuildItem& b){
+            return axisOf(a.centre,axis)<axisOf(b.centre,axis);
+        });
+        middle=first+n/2;
+    }
+
+    const uint32_t mid=static_cast<uint32_t>(middle-items.begin());
+    buildSubtree(items,nodes,begin,mid,depth+1);
+    const uint32_t right=buildSubtree(items,nodes,mid,end,depth+1);
+    nodes[node]=BVHNode{bounds,right,0};
+    return node;
+
+}
+
+} // namespace
+
+void StaticGeometry::build(std::vector<EdgeShape>&& edges){
+
+    // Takes ownership of edges, drops any mapped bake, and builds the tree.
+
+    m_file.close();
+    m_edges=std::move(edges);
+    buildNodes();
+    usePointers();
+
+}
+
+void StaticGeometry::usePointers(){
+    m_edgeData=m_edges.data();
+    m_edgeCount=m_edges.size();
+    m_nodeData=m_nodes.data();
+    m_nodeCount=m_nodes.size();
+}
+
+void StaticGeometry::buildNodes(){
+
+    // Builds the tree over m_edges, then reorders the edges into leaf order.
+
+    m_nodes.clear();
+    const size_t count=m_edges.size();
+    if (count==0) return;
+
+    std::vector<BuildItem> items(count);
+    for (size_t i=0;i<count;++i){
+        AABB box=getEdgeAABB(m_edges[i]);
+        items[i]={box,(box.min+box.max)*0.5f,static_cast<uint32_t>(i)};
+    }
+
+    m_nodes.reserve(2*count/kMaxLeafSize+1);
+    buildSubtree(items,m_nodes,0,static_cast<uint32_t>(count),0);
+
+    std::vector<EdgeShape> ordered;
+    ordered.reserve(count);
+    for (const BuildItem& item : items) ordered.push_back(m_edges[item.edge]);
+    m_edges.swap(ordered);
+
+}
+
+void StaticGeometry::assign(const StaticGeometry& other){
+    m_file.close();
+    m_edges.assign(other.m_edgeData,other.m_edgeData+other.m_edgeCount);
+    m_nodes.assign(other.m_nodeData,other.m_nodeData+other.m_nodeCount);
+    usePointers();
+}
+
+void StaticGeometry::translate(const Vec2& delta){
+
+    // A translation keeps every SAH split valid, so the tree is shifted in place rather than rebuilt.
+
+    if (isMapped()){
+        m_edges.assign(m_edgeData,m_edgeData+m_edgeCount);
+        m_nodes.assign(m_nodeData,m_nodeData+m_nodeCount);
+        m_file.close();
+        usePointers();
+    }
+    for (EdgeShape& edge : m_edges){
+        edge.v0+=delta;
+        edge.v1+=delta;
+        edge.v2+=delta;
+        edge.v3+=delta;
+    }
+    for (BVHNode& node : m_nodes){
+        node.box.min+=delta;
+        node.box.max+=delta;
+    }
+
+}
+
+bool StaticGeometry::save(const std::string& path) const{
+
+    using namespace bake;
+
+    BakeHeader header;
+    header.nodeCount=m_nodeCount;
+    header.edgeCount=m_edgeCount;
+    header.nodeOffset=alignUp(sizeof(BakeHeader));
+    header.edgeOffset=alignUp(header.nodeOffset+m_nodeCount*sizeof(BVHNode));
+
+    std::vector<unsigned char> bytes(header.edgeOffset+m_edgeCount*sizeof(EdgeShape),0);
+    std::memcpy(bytes.data(),&header,sizeof(BakeHeader));
+    if (m_nodeCount) std::memcpy(bytes.data()+header.nodeOffset,m_nodeData,m_nodeCount*sizeof(BVHNode));
+    if (m_edgeCount) std::memcpy(bytes.data()+header.edgeOffset,m_edgeData,m_edgeCount*sizeof(EdgeShape));
+
+    std::FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file) return false;
+    bool ok=std::fwrite(bytes.data(),1,bytes.size(),file)==bytes.size();
+    ok=(std::fclose(file)==0) && ok;
+    return ok;
+
+}
+
+bool StaticGeometry::load(const std::string& path){
+
+    // Validates the header and sections, then points straight into the mapping. Nothing is built or copied.
+
+    using namespace bake;
+
+    MappedFile file;
+    if (!file.open(path) || file.size()<sizeof(BakeHeader)) return false;
+
+    BakeHeader header;
+    std::memcpy(&header,file.data(),sizeof(BakeHeader));
+    if (header.magic!=kBakeMagic || header.version!=kBakeVersion) return false;
+    if (header.nodeSize!=sizeof(BVHNode) || header.edgeSize!=sizeof(EdgeShape)) return false;
+    if (header.nodeOffset%kSectionAlign || header.edgeOffset%kSectionAlign) return false;
+    // Counts are compared against the bytes left after each offset, so huge values cannot wrap the check
+    auto fits=[&](uint64_t offset,uint64_t count,size_t elementSize){
+        return offset<=file.size() && count<=(file.size()-offset)/elementSize;
+    };
+    if (!fits(header.nodeOffset,header.nodeCount,sizeof(BVHNode))) return false;
+    if (!fits(header.edgeOffset,header.edgeCount,sizeof(EdgeShape))) return false;
+
+    const auto* nodes=reinterpret_cast<const BVHNode*>(file.data()+header.nodeOffset);
+    for (uint64_t i=0;i<header.nodeCount;++i){ // Reject links outside the sections
+        const BVHNode& node=nodes[i];
+        if (node.count>0 ? node.index+uint64_t(node.count)>header.edgeCount : (node.index<=i || node.index>=header.nodeCount)) return false;
+    }
+
+    m_edges.clear();
+    m_nodes.clear();
+    m_file=std::move(file);
+    m_nodeData=nodes;
+    m_nodeCount=header.nodeCount;
+    m_edgeData=reinterpret_cast<const EdgeShape*>(m_file.data()+header.edgeOffset);
+    m_edgeCount=header.edgeCount;
+    return true;
+
+}
@@ -0,0 +1,240 @@
+// tiled_world.cpp
+// Tile streaming and origin rebasing for large worlds ( see core/TiledWorld.hpp ).
+
+#include "core/TiledWorld.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace {
+
+int32_t floorDiv(Real value,Real size){
+    // Clamped like partioning::cellCoord, so a runaway ( or NaN ) position never overflows the cast
+    Real tile=std::floor(value/size);
+    if (!(tile>Real(-partioning::kMaxCellCoord))) tile=Real(-partioning::kMaxCellCoord);
+    if (tile>Real(partioning::kMaxCellCoord)) tile=Real(partioning::kMaxCellCoord);
+    return static_cast<int32_t>(tile);
+}
+
+int32_t tileDistance(TileCoord a,TileCoord b){ return std::max(std::abs(a.x-b.x),std::abs(a.y-b.y)); }
+
+template <typename Tile>
+auto findTile(std::vector<Tile>& tiles,TileCoord coord){
+    return std::lower_bound(tiles.begin(),tiles.end(),coord,[](const Tile& t,TileCoord c){ return t.coord<c; });
+}
+
+} // namespace
+
+TiledWorld::TiledWorld(World& world, const TileConfig& config) : m_world(world), m_config(config) {
+    m_world.setYBounds(std::numeric_limits<Real>::infinity()); // A fixed cull plane would eat every tile below it
+}
+
+Vec2 TiledWorld::tileOffset(TileCoord tile) const{
+    return Vec2(static_cast<Real>(tile.x-m_origin.x)*m_config.tileSize,static_cast<Real>(tile.y-m_origin.y)*m_config.tileSize);
+}
+
+TileCoord TiledWorld::tileOf(const Vec2& simulated) const{
+    return TileCoord{m_origin.x+floorDiv(simulated.x,m_config.tileSize),m_origin.y+floorDiv(simulated.y,m_config.tileSize)};
+}
+
+Vec2 TiledWorld::toSimulation(const TilePosition& position) const{
+    return tileOffset(position.tile)+position.local;
+}
+
+TilePosition TiledWorld::toTile(const Vec2& simulated) const{
+    const TileCoord tile=tileOf(simulated);
+    return TilePosition{tile,simulated-tileOffset(tile)};
+}
+
+TilePosition TiledWorld::normalise(const TilePosition& position) const{
+    const int32_t dx=floorDiv(position.local.x,m_config.tileSize);
+    const int32_t dy=floorDiv(position.local.y,m_config.tileSize);
+    return TilePosition{TileCoord{position.tile.x+dx,position.tile.y+dy},
+                        position.local-Vec2(static_cast<Real>(dx)*m_config.tileSize,static_cast<Real>(dy)*m_config.tileSize)};
+}
+
+bool TiledWorld::isActive(TileCoord tile) const{
+    auto it=std::lower_bound(m_active.begin(),m_active.end(),tile,[](const ActiveTile& t,TileCoord c){ return t.coord<c; });
+    return it!=m_active.end() && it->coord==tile;
+}
+
+bool TiledWorld::isFrozen(TileCoord tile) const{
+    auto it=std::lower_bound(m_frozen.begin(),m_frozen.end(),tile,[](const FrozenTile& t,TileCoord c){ return t.coord<c; });
+    return it!=m_frozen.end() && it->coord==tile;
+}
+
+TiledWorld::FrozenTile& TiledWorld::frozenTile(TileCoord tile){
+    auto it=findTile(m_frozen,tile);
+    if (it==m_frozen.end() || it->coord!=tile){
+        it=m_frozen.insert(it,FrozenTile{});
+        it->coord=tile;
+    }
+    return *it;
+}
+
+void TiledWorld::freeze(FrozenTile& tile, const RigidBody& body, const Vec2& offset){
+
+    // World-space vertices are dropped, thawing rebuilds them from the pose.
+
+    snapshot::BodyRecord record=snapshot::makeRecord(body,tile.vertices,m_scratchTransformed,tile.children);
+    m_scratchTransformed.clear();
+    record.position-=offset;
+    record.transformedCount=0;
+    record.firstTransformed=0;
+    record.id=0;
+    tile.records.push_back(record);
+    m_stats.frozenBodies++;
+
+}
+
+void TiledWorld::createBodies(TileCoord tile, const BodyDef* defs, size_t count){
+
+    if (count==0) return;
+
+    if (isActive(tile)){
+        const Vec2 offset=tileOffset(tile);
+        std::vector<BodyDef> placed(defs,defs+count);
+        for (BodyDef& def : placed) def.position+=offset;
+        m_world.createBodies(placed.data(),placed.size());
+        return;
+    }
+
+    // Built by the World at their tile-local positions ( so no precision is lost on far tiles ), then frozen
+    // before any step can see them.
+    std::vector<BodyHandle> handles(count);
+    m_world.createBodies(defs,count,handles.data());
+    FrozenTile& frozen=frozenTile(tile);
+    for (BodyHandle handle : handles){
+        if (const RigidBody* body=m_world.getBody(handle)) freeze(frozen,*body,Vec2(0.0f,0.0f));
+    }
+    m_world.destroyBodies(handles);
+    m_stats.frozenTiles=m_frozen.size();
+
+}
+
+void TiledWorld::setObservers(const TilePosition* observers, size_t count){
+    m_observers.clear();
+    for (size_t i=0;i<count;++i) m_observers.push_back(normalise(observers[i]));
+}
+
+void TiledWorld::wantedTiles(std::vector<TileCoord>& out) const{
+    out.clear();
+    const int32_t r=m_config.activeRadius;
+    for (const TilePosition& observer : m_observers){
+        for (int32_t y=-r;y<=r;++y){
+            for (int32_t x=-r;x<=r;++x) out.push_back(TileCoord{observer.tile.x+x,observer.tile.y+y});
+        }
+    }
+    std::sort(out.begin(),out.end());
+    out.erase(std::unique(out.begin(),out.end()),out.end());
+}
+
+void TiledWorld::update(){
+
+    // Rebase first so freezing and thawing already work in the new coordinates. Every list is kept sorted
+    // by tile, so a given sequence of updates freezes and thaws in the same order on every run.
+
+    m_stats.frozenThisUpdate=0;
+    m_stats.thawedThisUpdate=0;
+    m_stats.culledThisUpdate=0;
+
+    if (!m_observers.empty() && tileDistance(m_observers[0].tile,m_origin)>=m_config.rebaseDistance){
+        const TileCoord target=m_observers[0].tile;
+        m_world.shiftOrigin(tileOffset(target));
+        m_origin=target;
+        m_stats.rebases++;
+    }
+
+    wantedTiles(m_wanted);
+    auto wanted=[&](TileCoord tile){ return std::binary_search(m_wanted.begin(),m_wanted.end(),tile); };
+
+    // Without the World's cull a body falling out of the map would accelerate forever, dragging the broad-phase
+    // bounds with it. Below cullDepth tiles under every active tile it is gone for good.
+    if (m_config.cullDepth>0 && !m_wanted.empty()){
+        const int32_t floor=m_wanted.front().y-m_config.cullDepth; // Row major, the first wanted tile is the lowest
+        std::vector<BodyHandle> culled;
+        for (const RigidBody& body : m_world.getBodies()){
+            if (body.id!=0 && !body.isStatic && tileOf(body.position).y<floor) culled.push_back(BodyHandle{body.id});
+        }
+        if (!culled.empty()) m_world.destroyBodies(culled);
+        m_stats.culledThisUpdate=static_cast<uint32_t>(culled.size());
+        m_stats.culledBodies+=culled.size();
+    }
+
+    // Group the simulated bodies by tile
+    std::vector<RigidBody>& bodies=m_world.getBodies();
+    m_bodyTiles.clear();
+    for (size_t i=0;i<bodies.size();++i){
+        if (bodies[i].id!=0) m_bodyTiles.push_back({tileOf(bodies[i].position),static_cast<uint32_t>(i)});
+    }
+    std::sort(m_bodyTiles.begin(),m_bodyTiles.end(),[](const auto& a,const auto& b){
+        return a.first<b.first || (a.first==b.first && a.second<b.second);
+    });
+
+    // Out of range tiles linger until they settle, then freeze
+    std::vector<ActiveTile> active;
+    std::vector<BodyHandle> frozenHandles;
+    const Real rest=m_config.restSpeed;
+    for (size_t begin=0;begin<m_bodyTiles.size();){
+        const TileCoord tile=m_bodyTiles[begin].first;
+        size_t end=begin;
+        while (end<m_bodyTiles.size() && m_bodyTiles[end].first==tile) ++end;
+
+        if (wanted(tile)){
+            begin=end;
+            continue;
+        }
+
+        auto previous=findTile(m_active,tile);
+        ActiveTile entry{tile,(previous!=m_active.end() && previous->coord==tile) ? previous->linger+1 : 1};
+
+        bool settled=true;
+        for (size_t i=begin;i<end && settled;++i){
+            const RigidBody& body=bodies[m_bodyTiles[i].second];
+            settled=body.isStatic || (body.linearVelocity.length()<rest && std::abs(body.angularVelocity)<rest);
+        }
+
+        if (settled || entry.linger>=m_config.maxLinger){
+            FrozenTile& frozen=frozenTile(tile);
+            const Vec2 offset=tileOffset(tile);
+            for (size_t i=begin;i<end;++i){
+                const RigidBody& body=bodies[m_bodyTiles[i].second];
+                freeze(frozen,body,offset);
+                frozenHandles.push_back(BodyHandle{body.id});
+            }
+            m_stats.frozenThisUpdate++;
+        } else {
+            active.push_back(entry);
+        }
+        begin=end;
+    }
+    if (!frozenHandles.empty()) m_world.destroyBodies(frozenHandles);
+
+    // Thaw every wanted tile that is frozen, in one batch
+    std::vector<RigidBody> thawed;
+    for (TileCoord tile : m_wanted){
+        active.push_back(ActiveTile{tile,0});
+        auto it=findTile(m_frozen,tile);
+        if (it==m_frozen.end() || it->coord!=tile) continue;
+
+        const Vec2 offset=tileOffset(tile);
+        for (const snapshot::BodyRecord& record : it->records){
+            thawed.emplace_back();
+            RigidBody& body=thawed.back();
+            snapshot::restoreRecord(record,it->vertices.data(),it->vertices.data(),it->children.data(),body);
+            body.position+=offset;
+            body.update=true;
+        }
+        m_stats.frozenBodies-=it->records.size();
+        m_frozen.erase(it);
+        m_stats.thawedThisUpdate++;
+    }
+    if (!thawed.empty()) m_world.addBodies(std::move(thawed));
+
+    std::sort(active.begin(),active.end(),[](const ActiveTile& a,const ActiveTile& b){ return a.coord<b.coord; });
+    m_active.swap(active);
+    m_stats.activeTiles=m_active.size();
+    m_stats.frozenTiles=m_frozen.size();
+
+}
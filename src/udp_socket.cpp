@@ -0,0 +1,90 @@
+// udp_socket.cpp
+// POSIX implementation of io/UdpSocket.hpp.
+
+#include "io/UdpSocket.hpp"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+bool resolve(const std::string& host, uint16_t port, Endpoint& out){
+    in_addr address{};
+    const char* name=host=="localhost" ? "127.0.0.1" : host.c_str();
+    if (inet_pton(AF_INET,name,&address)!=1) return false;
+    out.address=ntohl(address.s_addr);
+    out.port=port;
+    return true;
+}
+
+UdpSocket::~UdpSocket(){ close(); }
+
+UdpSocket::UdpSocket(UdpSocket&& other) noexcept : m_fd(std::exchange(other.m_fd,-1)) {}
+
+UdpSocket& UdpSocket::operator=(UdpSocket&& other) noexcept{
+    if (this!=&other){
+        close();
+        m_fd=std::exchange(other.m_fd,-1);
+    }
+    return *this;
+}
+
+bool UdpSocket::open(uint16_t port, size_t bufferBytes, uint32_t address){
+
+    close();
+    const int fd=::socket(AF_INET,SOCK_DGRAM,0);
+    if (fd<0) return false;
+
+    if (bufferBytes>0){ // Best effort, the kernel may clamp it
+        const int size=static_cast<int>(bufferBytes);
+        ::setsockopt(fd,SOL_SOCKET,SO_RCVBUF,&size,sizeof(size));
+        ::setsockopt(fd,SOL_SOCKET,SO_SNDBUF,&size,sizeof(size));
+    }
+
+    sockaddr_in local{};
+    local.sin_family=AF_INET;
+    local.sin_addr.s_addr=htonl(address);
+    local.sin_port=htons(port);
+    const int flags=::fcntl(fd,F_GETFL,0);
+    if (::bind(fd,reinterpret_cast<const sockaddr*>(&local),sizeof(local))!=0 || flags<0 ||
+        ::fcntl(fd,F_SETFL,flags|O_NONBLOCK)!=0){
+        ::close(fd);
+        return false;
+    }
+    m_fd=fd;
+    return true;
+
+}
+
+void UdpSocket::close(){
+    if (m_fd>=0) ::close(m_fd);
+    m_fd=-1;
+}
+
+uint16_t UdpSocket::localPort() const{
+    sockaddr_in address{};
+    socklen_t length=sizeof(address);
+    if (m_fd<0 || ::getsockname(m_fd,reinterpret_cast<sockaddr*>(&address),&length)!=0) return 0;
+    return ntohs(address.sin_port);
+}
+
+bool UdpSocket::send(const Endpoint& to, const void* data, size_t size){
+    if (m_fd<0) return false;
+    sockaddr_in address{};
+    address.sin_family=AF_INET;
+    address.sin_addr.s_addr=htonl(to.address);
+    address.sin_port=htons(to.port);
+    return ::sendto(m_fd,data,size,0,reinterpret_cast<const sockaddr*>(&address),sizeof(address))==static_cast<ssize_t>(size);
+}
+
+int UdpSocket::receive(void* data, size_t capacity, Endpoint& from){
+    if (m_fd<0) return -1;
+    sockaddr_in address{};
+    socklen_t length=sizeof(address);
+    const ssize_t received=::recvfrom(m_fd,data,capacity,0,reinterpret_cast<sockaddr*>(&address),&length);
+    if (received<0) return -1;
+    from.address=ntohl(address.sin_addr.s_addr);
+    from.port=ntohs(address.sin_port);
+    return static_cast<int>(received);
+}
@@ -0,0 +1,98 @@
+// vec_env.cpp
+// Vectorised environment over a WorldBatch ( see core/VecEnv.hpp ).
+
+#include "core/VecEnv.hpp"
+#include <algorithm>
+#include <utility>
+
+VecEnv::VecEnv(const VecEnvConfig& config, ResetFn reset)
+    : m_config(config), m_reset(std::move(reset)), m_batch(config.worlds,config.threads) {
+    m_observations.assign(observationSize(),0.0f);
+    m_slots.assign(m_batch.size()*m_config.maxBodies,BodyHandle{});
+}
+
+void VecEnv::bind(size_t index, const World& world){
+    const std::vector<RigidBody>& bodies=world.getBodies();
+    BodyHandle* slots=m_slots.data()+index*m_config.maxBodies;
+    for (size_t i=0;i<m_config.maxBodies;++i) slots[i]=i<bodies.size() ? BodyHandle{bodies[i].id} : BodyHandle{};
+}
+
+void VecEnv::write(size_t index, const World& world, float* rows) const{
+
+    const BodyHandle* slots=m_slots.data()+index*m_config.maxBodies;
+    for (size_t i=0;i<m_config.maxBodies;++i){
+        float* row=rows+i*kObservationFields;
+        const RigidBody* body=world.getBody(slots[i]);
+        if (!body){
+            std::fill(row,row+kObservationFields,0.0f);
+            continue;
+        }
+        row[ObservePositionX]=static_cast<float>(body->position.x);
+        row[ObservePositionY]=static_cast<float>(body->position.y);
+        row[ObserveRotation]=static_cast<float>(body->rotation);
+        row[ObserveVelocityX]=static_cast<float>(body->linearVelocity.x);
+        row[ObserveVelocityY]=static_cast<float>(body->linearVelocity.y);
+        row[ObserveAngularVelocity]=static_cast<float>(body->angularVelocity);
+        row[ObserveAlive]=1.0f;
+    }
+
+}
+
+void VecEnv::apply(size_t index, World& world, const float* rows) const{
+
+    const BodyHandle* slots=m_slots.data()+index*m_config.maxBodies;
+    for (size_t i=0;i<m_config.maxBodies;++i){
+        RigidBody* body=world.getBody(slots[i]);
+        if (!body || body->isStatic) continue;
+        const float* row=rows+i*kActionFields;
+        body->linearVelocity+=Vec2(static_cast<Real>(row[ActImpulseX]),static_cast<Real>(row[ActImpulseY]))*body->inverseMass;
+        body->angularVelocity+=static_cast<Real>(row[ActAngularImpulse])*body->inverseInertia;
+    }
+
+}
+
+void VecEnv::reset(){
+    m_batch.parallelFor([&](size_t index, World& world){
+        world=World();
+        m_reset(index,world);
+        world.refreshBroadphase(); // Gives bodies pushed through getBodies() their ids before they are bound
+        bind(index,world);
+        write(index,world,m_observations.data()+index*m_config.maxBodies*kObservationFields);
+    });
+}
+
+void VecEnv::reset(const uint32_t* worlds, size_t count){
+    for (size_t i=0;i<count;++i){ // Usually a handful per step, not worth a pool dispatch
+        const size_t index=worlds[i];
+        if (index>=m_batch.size()) continue;
+        World& world=m_batch.world(index);
+        world=World();
+        m_reset(index,world);
+        world.refreshBroadphase();
+        bind(index,world);
+        write(index,world,m_observations.data()+index*m_config.maxBodies*kObservationFields);
+    }
+}
+
+void VecEnv::step(const float* actions, float* observations){
+
+    // One pool dispatch per call: every world applies its actions, steps and writes its rows on one thread.
+
+    const size_t actionStride=m_config.maxBodies*kActionFields;
+    const size_t observationStride=m_config.maxBodies*kObservationFields;
+    if (!observations) observations=m_observations.data();
+    const Real dt=m_config.dt;
+    const int substeps=m_config.substeps;
+    m_batch.parallelFor([&](size_t index, World& world){
+        if (actions) apply(index,world,actions+index*actionStride);
+        for (int s=0;s<substeps;++s) world.step(dt);
+        write(index,world,observations+index*observationStride);
+    });
+
+}
+
+void VecEnv::observe(float* observations){
+    if (!observations) observations=m_observations.data();
+    const size_t stride=m_config.maxBodies*kObservationFields;
+    m_batch.parallelFor([&](size_t index, World& world){ write(index,world,observations+index*stride); });
+}
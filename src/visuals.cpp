@@ -176,7 +176,42 @@ void Visuals::drawRigidBody(const RigidBody& body){
         (void*)0
     );
 
-    glDrawArrays(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(body.transformedVertices.size()));
+    if (!body.isCompound()) {
+        glDrawArrays(GL_TRIANGLE_FAN, 0, static_cast<GLsizei>(body.transformedVertices.size()));
+    } else {
+        for (const ChildShape& child : body.children) { // One fan per convex piece
+            glDrawArrays(GL_TRIANGLE_FAN, static_cast<GLint>(child.first), static_cast<GLsizei>(child.count));
+        }
+    }
+
+    glBindVertexArray(0);
+
+}
+
+void Visuals::drawEdges(const EdgeShape* edges, size_t count){
+
+    // Uploads all edge endpoints at once and draws them as GL_LINES in the terrain colour.
+
+    if (!m_ok || count==0) return;
+
+    buffer.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const EdgeShape& edge = edges[i];
+        buffer.push_back(edge.v1.x);
+        buffer.push_back(edge.v1.y);
+        buffer.push_back(edge.v2.x);
+        buffer.push_back(edge.v2.y);
+    }
+
+    glUniform3f(m_colourLoc, 150.0f, 255.0f, 255.0f);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, buffer.size() * sizeof(float), buffer.data(), GL_DYNAMIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(count * 2));
 
     glBindVertexArray(0);
 
@@ -275,6 +310,7 @@ void Visuals::renderLoop(){
         for (auto& body:world.getBodies()){
             drawRigidBody(body);
         }
+        drawEdges(world.getStaticGeometry().edges(), world.getStaticGeometry().edgeCount());
 
         glfwSwapBuffers(m_window);
         glfwPollEvents();
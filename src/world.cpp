@@ -8,15 +8,42 @@
 #include "core/Transform.hpp"
 #include "collision/AABB.hpp"
 #include "collision/Partitioning.hpp"
+#include "collision/Compound.hpp"
+#include "io/Recorder.hpp"
 #include <cmath>
 #include <algorithm>
+#include <iterator>
 #include <iostream>
 
-std::pair<bool,bool> broadPhase(std::vector<RigidBody>& bodies,WorldStats& m_stats){ 
+static partioning::CollisionFilter filterOf(const RigidBody& body){
+    return {body.categoryBits, body.maskBits, body.groupIndex, static_cast<uint8_t>(body.isStatic), static_cast<uint8_t>(body.isSensor)};
+}
+
+static bool bodiesOverlap(const RigidBody& a, const RigidBody& b){
+    // Boolean overlap of two bodies, piece against nearby piece for compound bodies
+    return !forEachPiece(a, [&](VertexSpan pieceA){
+        return forEachPieceNear(b, pieceAABB(pieceA), [&](VertexSpan pieceB){ return !polygonsOverlap(pieceA, pieceB); });
+    });
+}
+
+static AABB inflate(AABB box, Real margin){
+    box.min -= Vec2(margin, margin);
+    box.max += Vec2(margin, margin);
+    return box;
+}
+
+std::pair<bool,bool> broadPhase(std::vector<RigidBody>& bodies,partioning::SpatialGrid& grid,std::vector<AABB>& aabbs,
+                                std::vector<std::pair<int,int>>& pairs,std::vector<partioning::CollisionFilter>& filters,
+                                WorldStats& m_stats,Real dt,bool speculative,std::vector<ContactSample>* contacts){ 
     
     // Broad-phase collision detection, returns whether the narrow phase was reached.
     // - Generates close candidate pairs (i,j) using AABBS and spatial partioning, where i and j are close in world-space.
     // - For each candidate pair, it is ensured their AABB overlaps, in which the narrow phase is then called for the candidate pair. 
+    // - grid, aabbs, pairs and filters are scratch storage owned by the World, reused every call.
+    // - Pairs rejected by collision filtering ( or both static ) never leave pair generation.
+    // - With speculative contacts, AABBs are stretched along each body's velocity*dt so pairs that
+    //   could meet during the step are found before they overlap.
+    // - contacts ( optional ) collects a ContactSample for every resolved touching pair.
     // Preconditions:
     // - A.transformedVertices / B.transformedVertices are rebuilt here via physEng::worldSpace().
     // Thread-safety: not thread-safe, run from physics thread only.
@@ -24,20 +51,27 @@ std::pair<bool,bool> broadPhase(std::vector<RigidBody>& bodies,WorldStats& m_sta
     bool narrowReached=false;
     bool inCollision=false;
 
-    std::vector<AABB> aabbs;
+    aabbs.clear();
     aabbs.reserve(bodies.size()); 
+    filters.clear();
+    filters.reserve(bodies.size());
 
     for (auto& body : bodies){ 
         // update world space vertices for bodies still in bounds 
 
         physEng::worldSpace(body); // Update each body from it's local space vertices to world space 
         AABB box=getAABB(body); // Construct it's AABB
+        if (speculative){
+            Vec2 sweep=body.linearVelocity*dt;
+            box.min.x+=std::min(sweep.x,Real(0)); box.max.x+=std::max(sweep.x,Real(0));
+            box.min.y+=std::min(sweep.y,Real(0)); box.max.y+=std::max(sweep.y,Real(0));
+        }
         aabbs.push_back(box);
+        filters.push_back(filterOf(body));
 
     }
 
-    partioning::GridConfig gridConfig;
-    auto pairs = partioning::buildPairsFromAABBs(aabbs, gridConfig); // Get canditate pairs which are close to each other in world-space 
+    partioning::buildPairsFromAABBs(aabbs, grid, pairs, &filters); // Get canditate pairs which are close to each other in world-space 
 
     for (auto [i,j] : pairs) { // Go through each canditate pair, i.e. i and j are close 
        
@@ -46,12 +80,11 @@ std::pair<bool,bool> broadPhase(std::vector<RigidBody>& bodies,WorldStats& m_sta
         RigidBody& A = bodies[i];
         RigidBody& B = bodies[j];
 
-        if (A.isStatic && B.isStatic) continue;
-
         // Do a final cheap check to ensure their AABBS are overlapping before running an SAT test 
         if (!AABBintersection(aabbs[i], aabbs[j])) continue;
         // At this point, it is very likely they are in collision, so we can run expensive SAT tests
-        narrowPhase(A, B, m_stats);
+        Real margin=speculative ? (B.linearVelocity-A.linearVelocity).length()*dt : 0.0f;
+        narrowPhase(A, B, m_stats, dt, margin, contacts);
         m_stats.narrowChecks++;
 
     }
@@ -59,7 +92,240 @@ std::pair<bool,bool> broadPhase(std::vector<RigidBody>& bodies,WorldStats& m_sta
     return {narrowReached,inCollision};
 }
 
-void World::step(float dt){ 
+void World::addBodies(std::vector<RigidBody>&& bodies){
+
+    // Appends a whole batch with a single reservation. Bodies are moved, so their vertex
+    // storage is transferred rather than copied. The broad-phase picks them up on the next step.
+    // Incoming bodies always get fresh ids.
+
+    assignIds();
+    for (auto& body : bodies) body.id=0;
+
+    if (m_bodies.empty()){
+        m_bodies=std::move(bodies);
+    } else {
+        m_bodies.reserve(m_bodies.size()+bodies.size());
+        std::move(bodies.begin(),bodies.end(),std::back_inserter(m_bodies));
+    }
+    bodies.clear();
+    refreshBroadphase();
+
+}
+
+void World::forkInto(World& dst) const{
+
+    // Bodies are matched by position in storage, id and vertex counts. Vectors are assigned rather than
+    // rebuilt, which reuses dst's capacity, so after the first fork nothing here allocates. Only bodies whose
+    // pose differs between the two Worlds pay for their world-space vertices.
+
+    if (&dst==this) return;
+
+    bool sameBodies=dst.m_bodies.size()==m_bodies.size();
+    for (size_t i=0;i<m_bodies.size() && sameBodies;++i){
+        const RigidBody& a=m_bodies[i];
+        const RigidBody& b=dst.m_bodies[i];
+        sameBodies=a.id!=0 && a.id==b.id && a.transformedVertices.size()==b.transformedVertices.size() &&
+                   a.children.size()==b.children.size();
+    }
+
+    if (sameBodies){
+        for (size_t i=0;i<m_bodies.size();++i){
+            const RigidBody& from=m_bodies[i];
+            RigidBody& to=dst.m_bodies[i];
+            const bool samePose=to.position==from.position && to.rotation==from.rotation && to.update==from.update;
+            to.force=from.force;
+            to.position=from.position;
+            to.rotation=from.rotation;
+            to.linearVelocity=from.linearVelocity;
+            to.linearAcceleration=from.linearAcceleration;
+            to.angularVelocity=from.angularVelocity;
+            to.angularAcceleration=from.angularAcceleration;
+            to.update=from.update;
+            if (samePose) continue; // World-space caches derive from the pose alone, static and resting bodies skip them
+            std::copy(from.transformedVertices.begin(),from.transformedVertices.end(),to.transformedVertices.begin());
+            for (size_t c=0;c<from.children.size();++c){
+                to.children[c].min=from.children[c].min;
+                to.children[c].max=from.children[c].max;
+            }
+        }
+    } else {
+        dst.m_bodies=m_bodies;
+    }
+
+    dst.solverIterations=solverIterations;
+    dst.gravity=gravity;
+    dst.m_yBounds=m_yBounds;
+    dst.m_stats=m_stats;
+    dst.m_nextId=m_nextId;
+    dst.m_deterministic=m_deterministic;
+    dst.m_speculative=m_speculative;
+    dst.m_lastStateHash=m_lastStateHash;
+    dst.m_grid=m_grid;
+    dst.m_aabbs=m_aabbs;
+    dst.m_sensorOverlaps=m_sensorOverlaps;
+    dst.m_prevSensorOverlaps=m_prevSensorOverlaps;
+    dst.m_sensorEvents=m_sensorEvents;
+    dst.m_contactEventsEnabled=m_contactEventsEnabled;
+    dst.m_impactThreshold=m_impactThreshold;
+    dst.m_touching=m_touching;
+    dst.m_prevTouching=m_prevTouching;
+    dst.m_contactEvents=m_contactEvents;
+    dst.m_static=m_static;
+    dst.m_nextChainId=m_nextChainId;
+
+}
+
+void World::assignIds(){
+
+    // Bodies appended through getBodies() have id 0, give them ids in storage order.
+    // As they always sit after every body with an id, m_bodies stays sorted by id.
+
+    for (auto& body : m_bodies){
+        if (body.id==0) body.id=m_nextId++;
+    }
+
+}
+
+namespace {
+
+// A polygon needs at least 3 vertices, and pieces ( when given ) must cover them exactly, as in snapshot loads
+bool validDef(const BodyDef& def){
+    if (!def.vertices || def.vertexCount<3) return false;
+    if (!def.pieceCounts) return true;
+    uint64_t pieceVertices=0;
+    for (size_t p=0;p<def.pieceCount;++p) pieceVertices+=def.pieceCounts[p];
+    return def.pieceCount>0 && pieceVertices==def.vertexCount;
+}
+
+} // namespace
+
+BodyHandle World::createBody(const BodyDef& def){
+    BodyHandle handle;
+    createBodies(&def,1,&handle);
+    return handle;
+}
+
+void World::createBodies(const BodyDef* defs, size_t count, BodyHandle* outHandles){
+
+    // Reserves once, then constructs every body in place.
+    // Mass properties are recomputed only when the vertex prototype changes between consecutive defs,
+    // so bursts of identical particles pay for them once.
+
+    assignIds(); // Keep ids ordered if bodies were pushed directly since the last step
+    m_bodies.reserve(m_bodies.size()+count);
+
+    const Vec2* lastVertices=nullptr;
+    size_t lastCount=0;
+    const uint32_t* lastPieces=nullptr;
+    Real area=0.0f, unitInertia=0.0f;
+
+    // Multi-shape defs are composed into pieces once per distinct shape list
+    const ShapeDef* lastShapes=nullptr;
+    size_t lastShapeCount=0;
+    std::vector<Vec2> composedVertices;
+    std::vector<uint32_t> composedCounts;
+    ComposedMass composed;
+    bool composedValid=false;
+
+    for (size_t i=0;i<count;++i){
+        if (defs[i].shapes){
+            const BodyDef& def=defs[i];
+            if (def.shapes!=lastShapes || def.shapeCount!=lastShapeCount){
+                composedVertices.clear();
+                composedCounts.clear();
+                lastShapes=def.shapes;
+                lastShapeCount=def.shapeCount;
+                composedValid=composeShapes(def.shapes,def.shapeCount,composedVertices,composedCounts,composed);
+            }
+            if (!composedValid){ // Skipped, its handle stays invalid
+                if (outHandles) outHandles[i]=BodyHandle{};
+                continue;
+            }
+
+            // The shapes were placed around the body frame origin, the body itself lives at their centre of mass
+            BodyDef placed=def;
+            placed.shapes=nullptr;
+            placed.vertices=composedVertices.data();
+            placed.vertexCount=composedVertices.size();
+            placed.pieceCounts=composedCounts.data();
+            placed.pieceCount=composedCounts.size();
+            const Real c=std::cos(def.rotation), s=std::sin(def.rotation);
+            placed.position=def.position+Vec2(composed.centre.x*c-composed.centre.y*s,composed.centre.x*s+composed.centre.y*c);
+            placed.mass=def.mass>0.0f ? def.mass : def.density*composed.weightedArea;
+
+            RigidBody& body=m_bodies.emplace_back(placed,composed.area,composed.unitInertia);
+            body.id=m_nextId++;
+            if (outHandles) outHandles[i]=BodyHandle{body.id};
+            continue;
+        }
+
+        const BodyDef& def=defs[i];
+        if (!validDef(def)){
+            if (outHandles) outHandles[i]=BodyHandle{};
+            continue;
+        }
+        if (def.vertices!=lastVertices || def.vertexCount!=lastCount || def.pieceCounts!=lastPieces){
+            if (def.pieceCounts && def.pieceCount>1) computePieceMassProperties(def.vertices,def.pieceCounts,def.pieceCount,area,unitInertia);
+            else computePolygonMassProperties(def.vertices,def.vertexCount,area,unitInertia);
+            lastVertices=def.vertices;
+            lastCount=def.vertexCount;
+            lastPieces=def.pieceCounts;
+        }
+
+        RigidBody& body=m_bodies.emplace_back(def,area,unitInertia);
+        body.id=m_nextId++;
+        if (outHandles) outHandles[i]=BodyHandle{body.id};
+    }
+
+    refreshBroadphase(); // One broad-phase rebuild for the whole batch
+
+}
+
+void World::createBodies(const std::vector<BodyDef>& defs, std::vector<BodyHandle>* outHandles){
+    if (outHandles) outHandles->resize(defs.size());
+    createBodies(defs.data(),defs.size(),outHandles ? outHandles->data() : nullptr);
+}
+
+void World::destroyBodies(const BodyHandle* handles, size_t count){
+
+    // Removes every listed body in a single compaction pass over m_bodies.
+
+    if (count==0) return;
+
+    std::vector<uint32_t> ids;
+    ids.reserve(count);
+    for (size_t i=0;i<count;++i) ids.push_back(handles[i].id);
+    std::sort(ids.begin(),ids.end());
+
+    m_bodies.erase(
+        std::remove_if(m_bodies.begin(), m_bodies.end(),
+            [&](const RigidBody& body) {
+                return body.id!=0 && std::binary_search(ids.begin(),ids.end(),body.id);
+            }),
+        m_bodies.end()
+    );
+
+    refreshBroadphase();
+
+}
+
+RigidBody* World::getBody(BodyHandle handle){
+    return const_cast<RigidBody*>(static_cast<const World*>(this)->getBody(handle));
+}
+
+const RigidBody* World::getBody(BodyHandle handle) const{
+
+    // Binary search, m_bodies is sorted by id ( bodies without an id yet sit at the end ).
+
+    if (!handle.isValid()) return nullptr;
+    auto it=std::lower_bound(m_bodies.begin(),m_bodies.end(),handle.id,
+        [](const RigidBody& body,uint32_t id){ return body.id!=0 && body.id<id; });
+    if (it==m_bodies.end() || it->id!=handle.id) return nullptr;
+    return &*it;
+
+}
+
+void World::step(Real dt){ 
 
     // Advances the simulation by dt seconds.
     // Order: integrate forces -> integrate velocities/positions -> detect/resove collisions.
@@ -68,13 +334,23 @@ void World::step(float dt){
     // Postconditions:
     // - Body transforms updated and caches invalidated (body.update = true on transform change).
 
+    assignIds();
+    if (m_grid.bodyCount()!=m_bodies.size()) refreshBroadphase(); // Bodies were pushed through getBodies(), bullets need the grid
+
     // Integrate
-    for (auto& body : m_bodies) {
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        RigidBody& body = m_bodies[i];
         if (!body.isStatic) {
 
             body.linearAcceleration = gravity;
             body.linearVelocity += body.linearAcceleration * dt;
-            body.position += body.linearVelocity * dt;
+            Vec2 delta = body.linearVelocity * dt;
+            if (body.isBullet && !body.isSensor) {
+                Real fraction = bulletTimeOfImpact(static_cast<int>(i), delta);
+                if (fraction < 1.0f) m_stats.ccdHits++;
+                delta = delta * fraction;
+            }
+            body.position += delta;
             body.rotation += body.angularVelocity * dt;
             body.force = Vec2(0, 0);
             body.update = true;
@@ -91,31 +367,230 @@ void World::step(float dt){
         m_bodies.end()
     );
 
+    m_contactSamples.clear();
     for (int i = 0; i < solverIterations; ++i) {
-        auto [narrowPhaseReached,colliding]=broadPhase(m_bodies,m_stats);
+        auto [narrowPhaseReached,colliding]=broadPhase(m_bodies,m_grid,m_aabbs,m_pairs,m_filters,m_stats,dt,m_speculative,
+                                                              m_contactEventsEnabled ? &m_contactSamples : nullptr);
         m_stats.narrowChecks+=(int)narrowPhaseReached;
         m_stats.contactsResolved+=(int)colliding;
+        edgePhase(dt);
     }
 
+    refreshBroadphase(); // Leave the grid current for queries until the next step
+    updateSensors(true);
+    if (m_contactEventsEnabled) updateContactEvents();
+
+    if (m_recorder) m_recorder->recordFrame(m_bodies);
+    if (m_deterministic) m_lastStateHash=stateHash();
+
     m_stats.steps++;
 
 }
 
+void World::updateContactEvents(){
+
+    // Folds this step's contact samples ( one per pair per solver iteration ) into one entry per pair,
+    // summing the normal impulse, then diffs the touching set against the previous step.
+    // The solver itself only appends to a flat array, no callbacks run mid-solve.
+
+    m_contactEvents.begin.clear();
+    m_contactEvents.end.clear();
+    m_contactEvents.impacts.clear();
+
+    std::sort(m_contactSamples.begin(),m_contactSamples.end(),[](const ContactSample& x,const ContactSample& y){
+        return x.a<y.a || (x.a==y.a && x.b<y.b);
+    });
+
+    m_prevTouching.swap(m_touching);
+    m_touching.clear();
+
+    for (size_t s=0;s<m_contactSamples.size();){
+        const ContactSample& first=m_contactSamples[s];
+        Real impulse=0.0f;
+        size_t e=s;
+        for (;e<m_contactSamples.size() && m_contactSamples[e].a==first.a && m_contactSamples[e].b==first.b;++e){
+            impulse+=m_contactSamples[e].impulse;
+        }
+        m_touching.push_back({first.a,first.b});
+        if (impulse>=m_impactThreshold){
+            m_contactEvents.impacts.push_back({BodyHandle{first.a},BodyHandle{first.b},first.point,first.normal,impulse});
+        }
+        s=e;
+    }
+
+    // Both sets are sorted by id pair
+    size_t a=0,b=0;
+    while (a<m_prevTouching.size() || b<m_touching.size()){
+        if (b==m_touching.size() || (a<m_prevTouching.size() && m_prevTouching[a]<m_touching[b])){
+            const auto& p=m_prevTouching[a++];
+            m_contactEvents.end.push_back({BodyHandle{p.first},BodyHandle{p.second}});
+        } else if (a==m_prevTouching.size() || m_touching[b]<m_prevTouching[a]){
+            const auto& p=m_touching[b++];
+            m_contactEvents.begin.push_back({BodyHandle{p.first},BodyHandle{p.second}});
+        } else {
+            ++a; ++b;
+        }
+    }
+
+}
+
+void World::updateSensors(bool emitEvents){
+
+    // Collects every (sensor, body) overlap at the end-of-step poses with a boolean SAT test,
+    // then diffs against the previous step's overlaps to produce begin/end events.
+    // Only sensors drive the search, so worlds without sensors pay one scan of the body flags.
+    // Requires a current grid ( refreshBroadphase ). emitEvents=false only re-seeds the overlap set.
+
+    m_sensorEvents.clear();
+    m_prevSensorOverlaps.swap(m_sensorOverlaps);
+    m_sensorOverlaps.clear();
+
+    for (size_t i = 0; i < m_bodies.size(); ++i) {
+        const RigidBody& sensor = m_bodies[i];
+        if (!sensor.isSensor) continue;
+
+        const partioning::CollisionFilter sensorFilter = filterOf(sensor);
+        queryAABB(m_aabbs[i], [&](int, const RigidBody& body){
+            if (body.isSensor) return true; // Sensors do not detect each other
+            if (!partioning::shouldCollide(sensorFilter, filterOf(body))) return true;
+            if (bodiesOverlap(sensor, body)) {
+                m_sensorOverlaps.push_back({sensor.id, body.id});
+            }
+            return true;
+        });
+    }
+
+    std::sort(m_sensorOverlaps.begin(), m_sensorOverlaps.end());
+    if (!emitEvents) return;
+
+    // Both lists are sorted, so one merge finds what started and what stopped overlapping
+    size_t a = 0, b = 0;
+    while (a < m_prevSensorOverlaps.size() || b < m_sensorOverlaps.size()) {
+        if (b == m_sensorOverlaps.size() || (a < m_prevSensorOverlaps.size() && m_prevSensorOverlaps[a] < m_sensorOverlaps[b])) {
+            const auto& p = m_prevSensorOverlaps[a++];
+            m_sensorEvents.push_back({BodyHandle{p.first}, BodyHandle{p.second}, false});
+        } else if (a == m_prevSensorOverlaps.size() || m_sensorOverlaps[b] < m_prevSensorOverlaps[a]) {
+            const auto& p = m_sensorOverlaps[b++];
+            m_sensorEvents.push_back({BodyHandle{p.first}, BodyHandle{p.second}, true});
+        } else {
+            ++a; ++b;
+        }
+    }
+
+}
+
+Real World::bulletTimeOfImpact(int index, const Vec2& delta) const{
+
+    // Sweeps bullet index along delta against every non-bullet body near its path.
+    // All bodies are taken at their pose from the end of the previous step ( transformedVertices
+    // are only rebuilt by the broad-phase ), so the result does not depend on integration order.
+    // Returns the fraction of delta the bullet may travel, 1 when the path is clear.
+
+    const RigidBody& bullet = m_bodies[index];
+    const Real length = delta.length();
+    if (length <= 0.0f || bullet.transformedVertices.empty()) return 1.0f;
+
+    AABB box = m_aabbs[index];
+    AABB swept{
+        Vec2(std::min(box.min.x, box.min.x + delta.x), std::min(box.min.y, box.min.y + delta.y)),
+        Vec2(std::max(box.max.x, box.max.x + delta.x), std::max(box.max.y, box.max.y + delta.y))
+    };
+
+    Real best = 1.0f;
+    queryAABB(swept, [&](int other, const RigidBody& body){
+        if (other == index || body.isBullet || body.isSensor) return true;
+        if (!partioning::shouldCollide(filterOf(bullet), filterOf(body))) return true;
+
+        forEachPiece(bullet, [&](VertexSpan piece){
+            AABB pieceBox = pieceAABB(piece);
+            pieceBox.min += Vec2(std::min(delta.x, Real(0)), std::min(delta.y, Real(0)));
+            pieceBox.max += Vec2(std::max(delta.x, Real(0)), std::max(delta.y, Real(0)));
+            return forEachPieceNear(body, pieceBox, [&](VertexSpan target){
+                Real fraction;
+                Vec2 normal, point;
+                if (sweepPolygons(piece, delta, target, best, fraction, normal, point)) {
+                    if (fraction > 0.0f) best = std::min(best, fraction); // Overlaps at 0 are left to the solver
+                }
+                return true;
+            });
+        });
+        return true;
+    });
+
+    // Static edges the path crosses from their front side
+    if (!m_static->empty()) {
+        const partioning::CollisionFilter filter = filterOf(bullet);
+        std::vector<Vec2> segment(2);
+
+        m_static->query(swept, [&](uint32_t, const EdgeShape& edge){
+            if (vecMath::dot(delta, edge.normal) >= 0.0f) return; // Moving away or along
+            if (vecMath::dot(bullet.position - edge.v1, edge.normal) < 0.0f) return; // Behind it
+            if (!partioning::shouldCollide(edge.filter, filter)) return;
+
+            segment[0] = edge.v1;
+            segment[1] = edge.v2;
+            forEachPiece(bullet, [&](VertexSpan piece){
+                Real fraction;
+                Vec2 normal, point;
+                if (sweepPolygons(piece, delta, segment, best, fraction, normal, point) && fraction > 0.0f) {
+                    best = std::min(best, fraction);
+                }
+                return true;
+            });
+        });
+    }
+
+    if (best >= 1.0f) return 1.0f;
+
+    const Real slop = 0.01f; // Push slightly into the contact so the narrow phase picks it up
+    return std::min(Real(1), best + slop / length);
+
+}
+
+uint64_t World::stateHash() const{
+
+    // FNV-1a over the raw bits of every body's transform and velocities, in body order.
+    // Two worlds only hash equal if their states are bit-identical ( -0.0f and 0.0f differ ).
+
+    uint64_t hash=1469598103934665603ull;
+    auto mix=[&hash](const void* data,size_t size){
+        const unsigned char* bytes=static_cast<const unsigned char*>(data);
+        for (size_t i=0;i<size;++i){
+            hash^=bytes[i];
+            hash*=1099511628211ull;
+        }
+    };
+
+    uint64_t count=m_bodies.size();
+    mix(&count,sizeof(count));
+    for (const RigidBody& body : m_bodies){
+        mix(&body.position,sizeof(body.position));
+        mix(&body.rotation,sizeof(body.rotation));
+        mix(&body.linearVelocity,sizeof(body.linearVelocity));
+        mix(&body.angularVelocity,sizeof(body.angularVelocity));
+    }
+    return hash;
+
+}
+
 struct impulseManifold{ // Used to store impulses to apply all impulses only once all contact points are accounted for 
     Vec2 impulse;
     Vec2 rA;
     Vec2 rB;
 };
 
-void resolveCollision(Manifold& manifold){
+Real resolveCollision(Manifold& manifold,Real dt){
 
     // Resolves collision by applying impulses at each contact point.
     // Preconditions:
     // - manifold.inCollision == true
     // - manifold.normal is unit length and points from A -> B
     // - contactCount in [1,2] and contact points are valid
+    // - A negative penetration marks a speculative contact ( gap = -penetration ), which only removes the
+    //   part of the approach velocity that would close more than the gap within dt.
     // Effects:
     // - Modifies A/B linearVelocity and angularVelocity.
+    // Returns the total normal impulse applied.
 
     RigidBody& A=manifold.A;
     RigidBody& B=manifold.B;
@@ -130,8 +605,9 @@ void resolveCollision(Manifold& manifold){
 
     impulses.reserve(contacts.size());
 
-    float staticFriction=std::min(A.staticFriction,B.staticFriction);
-    float dynamicFriction=std::min(A.dynamicFriction,B.dynamicFriction);
+    Real staticFriction=std::min(A.staticFriction,B.staticFriction);
+    Real dynamicFriction=std::min(A.dynamicFriction,B.dynamicFriction);
+    Real normalImpulse=0.0f;
 
     for (auto& contact : contacts){ // Create impulse for each contact point 
 
@@ -152,25 +628,32 @@ void resolveCollision(Manifold& manifold){
 
         Vec2 tangent=relativeVel-normal*vecMath::dot(relativeVel,normal);
         
-        float velAlongNormal = vecMath::dot(relativeVel, manifold.normal);
+        Real velAlongNormal = vecMath::dot(relativeVel, manifold.normal);
         if (velAlongNormal > 0.0f) continue;  // If they are already separating along the normal, so the collision is going to resolve on its own
 
-        bool applyFriction=true;
+        const bool speculative = manifold.penetration < 0.0f;
+        if (speculative) {
+            velAlongNormal += -manifold.penetration / dt; // Approach allowed to just close the gap this step
+            if (velAlongNormal >= 0.0f) continue;
+        }
+
+        bool applyFriction=!speculative; // Not touching yet, so no friction
         
-        if (vecMath::floatCloselyEqual(tangent.length(),0)){ // Allow box to microsettle ( stay flat once all velocity is lost )
+        if (!applyFriction || vecMath::floatCloselyEqual(tangent.length(),0)){ // Allow box to microsettle ( stay flat once all velocity is lost )
             applyFriction=false;  
         } else { 
             tangent=tangent.normalise();
         }
 
-        float rADot=vecMath::dot(rA,normal);
-        float rBDot=vecMath::dot(rB,normal);
-        float minRestitiution = std::min(A.restitution,B.restitution); // Variable e 
+        Real rADot=vecMath::dot(rA,normal);
+        Real rBDot=vecMath::dot(rB,normal);
+        Real minRestitiution = speculative ? 0.0f : std::min(A.restitution,B.restitution); // Variable e 
 
-        float denominator= (A.inverseMass + B.inverseMass + (rADot*rADot)*A.inverseInertia + (rBDot*rBDot)*B.inverseInertia  ); 
-        float j = -(1.0f + minRestitiution) * velAlongNormal;
+        Real denominator= (A.inverseMass + B.inverseMass + (rADot*rADot)*A.inverseInertia + (rBDot*rBDot)*B.inverseInertia  ); 
+        Real j = -(1.0f + minRestitiution) * velAlongNormal;
         j /= denominator;
-        j /= static_cast<float>(manifold.contactCount);
+        j /= static_cast<Real>(manifold.contactCount);
+        normalImpulse+=j;
 
         // Rotational and linear manifold 
         Vec2 impulse=manifold.normal*j;
@@ -180,18 +663,18 @@ void resolveCollision(Manifold& manifold){
         // Friction manifold 
         if (applyFriction){
 
-            float rADotTangential=vecMath::dot(rA,tangent);
-            float rBDotTangential=vecMath::dot(rB,tangent);
+            Real rADotTangential=vecMath::dot(rA,tangent);
+            Real rBDotTangential=vecMath::dot(rB,tangent);
 
-            float denominatorTangential= (
+            Real denominatorTangential= (
                 A.inverseMass + B.inverseMass + 
                 (rADotTangential*rADotTangential)*A.inverseInertia + 
                 (rBDotTangential*rBDotTangential)*B.inverseInertia
             );
 
-            float jTangent = -vecMath::dot(relativeVel, tangent);;
+            Real jTangent = -vecMath::dot(relativeVel, tangent);;
             jTangent /= denominatorTangential;
-            jTangent /= static_cast<float>(manifold.contactCount);
+            jTangent /= static_cast<Real>(manifold.contactCount);
 
             Vec2 frictionImpulse;
 
@@ -217,11 +700,37 @@ void resolveCollision(Manifold& manifold){
         B.angularVelocity += vecMath::cross(impulseData.rB, impulseData.impulse) * B.inverseInertia;
     }
 
+    return normalImpulse;
 
 };
 
 
-bool narrowPhase(RigidBody& A, RigidBody& B,WorldStats& m_stats){  
+static bool resolveContact(Manifold& m,WorldStats& m_stats,Real dt,std::vector<ContactSample>* contacts){
+
+    // Resolves one colliding manifold: impulses, the optional contact sample, then positional correction.
+
+#ifdef PHYS_PRESOLVE_HOOK
+    if (!PHYS_PRESOLVE_HOOK(m)) return false; // Application chose to ignore this contact
+#endif
+
+    RigidBody& A=m.A;
+    RigidBody& B=m.B;
+    Real impulse=resolveCollision(m, dt); // At this point, the two objects are colliding, so we must resolve the collision
+    m_stats.contactsResolved++;
+
+    if (contacts && m.penetration>=0.0f){
+        Vec2 point=m.contactCount>1 ? (m.contact1+m.contact2)*0.5f : m.contact1;
+        if (A.id<B.id) contacts->push_back({A.id, B.id, point, m.normal, impulse});
+        else contacts->push_back({B.id, A.id, point, m.normal*-1, impulse});
+    }
+
+    correctPositions(m); // Apply position correction afterwards to seperate the two objects.
+    return true;
+
+}
+
+bool narrowPhase(RigidBody& A, RigidBody& B,WorldStats& m_stats,Real dt,Real speculativeMargin,
+                 std::vector<ContactSample>* contacts){  
     
     // Narrow-phase collision detection and resolution for a candidate body pair, return whether a collision was resolved 
     // ( i.e. whether there was actually a collision)
@@ -229,31 +738,203 @@ bool narrowPhase(RigidBody& A, RigidBody& B,WorldStats& m_stats){
     // Preconditions:
     // - A and B have passed broad-phase testing.
     // - A.transformedVertices and B.transformedVertices are up-to-date.
+    // - speculativeMargin > 0 also resolves pairs whose gap is within the margin ( requires dt > 0 ).
+    // - contacts, if non-null, receives one sample per touching ( non-speculative ) pair resolved.
     //
     // Effects:
     // - Applies impulse-based collision resolution.
     // - May modify A/B positions via penetration correction.
 
-    Manifold m = SATCollision(A, B); // Apply the SAT test to objectively discern if they are in collision
-    if (!m.inCollision) return false; // Two objects are not colliding. we can stop here
+    if (!A.isCompound() && !B.isCompound()){
+        Manifold m = SATCollision(A, B, speculativeMargin); // Apply the SAT test to objectively discern if they are in collision
+        if (!m.inCollision) return false; // Two objects are not colliding. we can stop here
+        return resolveContact(m, m_stats, dt, contacts);
+    }
 
-    resolveCollision(m); // At this point, the two objects are colliding, so we must resolve the collision
-    m_stats.contactsResolved++;
+    // Compound mid-phase: only child pairs whose cached boxes overlap reach SAT. Every touching
+    // piece pair is its own contact between the two parent bodies.
+    bool resolved=false;
+    forEachChildPair(A, getAABB(A), B, getAABB(B), speculativeMargin, [&](VertexSpan pieceA, VertexSpan pieceB){
+        m_stats.childChecks++;
+        PolygonContact c;
+        if (!collidePolygons(pieceA, pieceCentre(pieceA), pieceB, pieceCentre(pieceB), speculativeMargin, c)) return;
+        Manifold m{A, B, c.normal, c.contact1, c.contact2, c.contactCount, c.penetration, true};
+        resolved|=resolveContact(m, m_stats, dt, contacts);
+    });
+    return resolved;
 
-    // Apply position correction afterwards to seperate the two objects.
+}
+
+void correctPositions(Manifold& m){
+
+    // Pushes the bodies of a resolved manifold apart along its normal, by a fraction of the penetration.
 
-    const float percent = 0.8f;  // Error percentage 
-    const float slop = 0.01f; // Precision, based on world distance unit 
+    RigidBody& A=m.A;
+    RigidBody& B=m.B;
 
-    float invMassSum = A.inverseMass+B.inverseMass; // Zero implies two static bodies
+    const Real percent = 0.8f;  // Error percentage 
+    const Real slop = 0.01f; // Precision, based on world distance unit 
+
+    Real invMassSum = A.inverseMass+B.inverseMass; // Zero implies two static bodies
     if (invMassSum > 0.f){ 
         // Positional correction if two objects are colliding and one is non-static based on penetration depth 
-        float corrMag = std::max(m.penetration - slop, 0.f) / invMassSum * percent;
+        Real corrMag = std::max(m.penetration - slop, Real(0)) / invMassSum * percent;
         Vec2 correction = m.normal * corrMag;
         if (!A.isStatic) { A.position -= correction * A.inverseMass; A.update=true; } // Invalidate cache as position cahnged 
         if (!B.isStatic) { B.position += correction * B.inverseMass; B.update=true; } 
     }
 
+}
+
+void World::edgePhase(Real dt){
+
+    // Collides every dynamic body with the static edges near it, found through the baked static BVH
+    // ( which only changes with chains or a loaded bake ), so each body costs O(log edges + edges touched).
+    // Runs after broadPhase(), which leaves world-space vertices and m_aabbs current.
+
+    if (m_static->empty()) return;
+
+    m_edgeProxy.isStatic=true; // Stands in for the edge in the Manifold, never moves
+
+    for (size_t i=0;i<m_bodies.size();++i){
+        RigidBody& body=m_bodies[i];
+        if (body.isStatic || body.isSensor || body.transformedVertices.empty()) continue;
+
+        const partioning::CollisionFilter filter=filterOf(body);
+        const Real margin=m_speculative ? body.linearVelocity.length()*dt : 0.0f;
+
+        m_static->query(m_aabbs[i],[&](uint32_t,const EdgeShape& edge){
+            m_stats.broadChecks++;
+            if (!partioning::shouldCollide(edge.filter,filter)) return;
+
+            forEachPieceNear(body,inflate(getEdgeAABB(edge),margin),[&](VertexSpan piece){
+                m_stats.narrowChecks++;
+                EdgeContact contact;
+                const Vec2 centre=body.isCompound() ? pieceCentre(piece) : body.position;
+                if (!collideEdgePolygon(edge,piece,centre,margin,contact)) return true;
+
+                m_edgeProxy.position=edge.v1;
+                m_edgeProxy.staticFriction=edge.staticFriction;
+                m_edgeProxy.dynamicFriction=edge.dynamicFriction;
+                m_edgeProxy.restitution=edge.restitution;
+
+                Manifold m{m_edgeProxy,body,contact.normal,contact.points[0],contact.points[1],contact.count,contact.penetration,true};
+#ifdef PHYS_PRESOLVE_HOOK
+                if (!PHYS_PRESOLVE_HOOK(m)) return true;
+#endif
+                resolveCollision(m,dt);
+                m_stats.contactsResolved++;
+                correctPositions(m);
+                return true;
+            });
+        });
+    }
+
+}
+
+ChainHandle World::createChain(const ChainDef& def){
+    ChainHandle handle;
+    createChains(&def,1,&handle);
+    return handle;
+}
+
+void World::createChains(const ChainDef* defs, size_t count, ChainHandle* outHandles){
+
+    // Splits each polyline into one edge per segment, each knowing its neighbours as ghost vertices,
+    // then rebakes the static BVH once for the whole batch.
+
+    std::vector<EdgeShape> edges(m_static->edges(),m_static->edges()+m_static->edgeCount());
+
+    for (size_t c=0;c<count;++c){
+        const ChainDef& def=defs[c];
+        const size_t points=def.count;
+        if (!def.points || points<2 || (def.loop && points<3)){
+            if (outHandles) outHandles[c]=ChainHandle{};
+            continue;
+        }
+
+        ChainHandle handle{m_nextChainId++};
+        if (outHandles) outHandles[c]=handle;
+        const Vec2* p=def.points;
+        const size_t segments=def.loop ? points : points-1;
+        edges.reserve(edges.size()+segments);
+
+        for (size_t s=0;s<segments;++s){
+            EdgeShape edge;
+            edge.v1=p[s];
+            edge.v2=p[(s+1)%points];
+            Vec2 along=edge.v2-edge.v1;
+            edge.normal=Vec2(-along.y,along.x).normalise();
+
+            if (def.loop || s>0) { edge.v0=p[(s+points-1)%points]; edge.hasV0=1; }
+            if (def.loop || s+2<points) { edge.v3=p[(s+2)%points]; edge.hasV3=1; }
+
+            edge.chain=handle.id;
+            edge.staticFriction=def.staticFriction;
+            edge.dynamicFriction=def.dynamicFriction;
+            edge.restitution=def.restitution;
+            edge.filter={def.categoryBits,def.maskBits,def.groupIndex,1,0};
+            edges.push_back(edge);
+        }
+    }
+
+    rebuildStatic(std::move(edges));
+
+}
+
+void World::destroyChain(ChainHandle chain){
+    std::vector<EdgeShape> edges;
+    edges.reserve(m_static->edgeCount());
+    for (size_t i=0;i<m_static->edgeCount();++i){
+        if (m_static->edges()[i].chain!=chain.id) edges.push_back(m_static->edges()[i]);
+    }
+    rebuildStatic(std::move(edges));
+}
+
+void World::rebuildStatic(std::vector<EdgeShape>&& edges){
+    auto geometry=std::make_shared<StaticGeometry>();
+    geometry->build(std::move(edges));
+    m_static=std::move(geometry);
+}
+
+void World::setStaticGeometry(std::shared_ptr<const StaticGeometry> geometry){
+    m_static=geometry ? std::move(geometry) : std::make_shared<const StaticGeometry>();
+    for (size_t i=0;i<m_static->edgeCount();++i){
+        m_nextChainId=std::max(m_nextChainId,m_static->edges()[i].chain+1);
+    }
+}
+
+void World::shiftOrigin(const Vec2& origin){
+
+    // Rebases every coordinate the World stores. Transforms are rebuilt from the shifted positions rather than
+    // shifted themselves, so vertices are exactly what a body created at the new position would have.
+
+    for (RigidBody& body : m_bodies){
+        body.position-=origin;
+        body.update=true;
+    }
+    if (!m_static->empty()){ // Shifted copy, other Worlds may share the current bake
+        auto moved=std::make_shared<StaticGeometry>();
+        moved->assign(*m_static);
+        moved->translate(Vec2(-origin.x,-origin.y));
+        m_static=std::move(moved);
+    }
+    m_yBounds+=origin.y; // The plane stays put in absolute terms
+    refreshBroadphase();
+
+}
+
+bool World::saveStaticGeometry(const std::string& path) const{
+    return m_static->save(path);
+}
+
+bool World::loadStaticGeometry(const std::string& path){
+
+    // Replaces every edge with a baked level. The bake is used in place, nothing is rebuilt.
+
+    auto geometry=std::make_shared<StaticGeometry>();
+    if (!geometry->load(path)) return false;
+    setStaticGeometry(std::move(geometry)); // New chains never reuse baked ids
     return true;
 
 }
@@ -0,0 +1,149 @@
+// world_batch.cpp
+// Work stealing thread pool stepping many independent Worlds ( see core/WorldBatch.hpp ).
+
+#include "core/WorldBatch.hpp"
+#include <algorithm>
+#include <utility>
+
+WorldBatch::WorldBatch(size_t worldCount, size_t threadCount){
+
+    if (threadCount==0) threadCount=std::max<size_t>(1,std::thread::hardware_concurrency());
+    threadCount=std::max<size_t>(1,std::min(threadCount,std::max<size_t>(1,worldCount)));
+
+    m_worlds.reserve(worldCount);
+    for (size_t i=0;i<worldCount;++i) m_worlds.push_back(std::make_unique<World>());
+
+    for (size_t i=0;i<threadCount;++i) m_queues.push_back(std::make_unique<WorkQueue>());
+    try {
+        for (size_t i=1;i<threadCount;++i) m_threads.emplace_back(&WorldBatch::workerLoop,this,i); // Queue 0 is the caller's
+    } catch (...){
+        stop(); // The destructor will not run, so the started threads must not outlive the failure
+        throw;
+    }
+
+}
+
+WorldBatch::~WorldBatch(){ stop(); }
+
+void WorldBatch::stop(){
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop=true;
+    }
+    m_wake.notify_all();
+    for (std::thread& thread : m_threads) thread.join();
+    m_threads.clear();
+}
+
+void WorldBatch::setStaticGeometry(std::shared_ptr<const StaticGeometry> geometry){
+    for (auto& world : m_worlds) world->setStaticGeometry(geometry);
+}
+
+void WorldBatch::createBodies(const BodyDef* defs, size_t count){
+    for (auto& world : m_worlds) world->createBodies(defs,count);
+}
+
+void WorldBatch::step(Real dt, int steps){
+    run([dt,steps](size_t, World& world){
+        for (int s=0;s<steps;++s) world.step(dt);
+    });
+}
+
+void WorldBatch::parallelFor(const std::function<void(size_t, World&)>& fn){
+    run(fn);
+}
+
+void WorldBatch::run(const std::function<void(size_t, World&)>& fn){
+
+    // Publishes the task before filling the queues, so any worker that takes an index ( even one still
+    // finishing the previous run ) sees it through the queue mutex.
+
+    if (m_worlds.empty()) return;
+
+    m_task=&fn;
+    m_remaining.store(m_worlds.size(),std::memory_order_relaxed);
+
+    const size_t workers=m_queues.size();
+    const size_t count=m_worlds.size();
+    for (size_t i=0;i<workers;++i){
+        WorkQueue& queue=*m_queues[i];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin=static_cast<uint32_t>(count*i/workers);
+        queue.end=static_cast<uint32_t>(count*(i+1)/workers);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock,[&]{ return m_remaining.load(std::memory_order_acquire)==0; });
+    m_task=nullptr;
+    if (m_error) std::rethrow_exception(std::exchange(m_error,nullptr));
+
+}
+
+bool WorldBatch::take(size_t self, uint32_t& task){
+
+    // Own work from the front, then one task at a time from the back of the other queues, starting with the
+    // next worker along so thieves spread out rather than all hitting queue 0.
+
+    {
+        WorkQueue& own=*m_queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.begin<own.end){
+            task=own.begin++;
+            return true;
+        }
+    }
+
+    const size_t workers=m_queues.size();
+    for (size_t k=1;k<workers;++k){
+        WorkQueue& victim=*m_queues[(self+k)%workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.begin<victim.end){
+            task=--victim.end;
+            m_steals.fetch_add(1,std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+
+}
+
+void WorldBatch::work(size_t self){
+
+    uint32_t task;
+    while (take(self,task)){
+        try {
+            (*m_task)(task,*m_worlds[task]);
+        } catch (...){
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_error) m_error=std::current_exception();
+        }
+        if (m_remaining.fetch_sub(1,std::memory_order_acq_rel)==1){
+            std::lock_guard<std::mutex> lock(m_mutex); // Pairs with the wait in run()
+            m_done.notify_one();
+        }
+    }
+
+}
+
+void WorldBatch::workerLoop(size_t self){
+
+    uint64_t seen=0;
+    for (;;){
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock,[&]{ return m_stop || m_generation!=seen; });
+            if (m_stop) return;
+            seen=m_generation;
+        }
+        work(self);
+    }
+
+}
@@ -0,0 +1,338 @@
+// bench.cpp
+// Headless micro benchmarks for engine design choices.
+
+// Usage:
+//   PhysBench scalar [bodies] [steps]   Rigid box kernel ( integrate, transform, bounce ) per scalar type ( float, double, Q16.16 )
+//   PhysBench batch [worlds] [steps]    WorldBatch farm of uneven box piles, one thread against the whole pool
+//   PhysBench fork [bodies] [forks]     World::forkInto() of a settling box field, first ( full ) and repeated forks
+//   PhysBench rollback [bodies] [frames] RollbackBuffer save, restore and an 8 frame resimulation per frame
+//   PhysBench world [bodies] [steps]    World::step() of a settling box field in this build's Real ( float, or
+//                                       double with PHYS_DOUBLE_PRECISION ), run it from both builds to compare
+// Every benchmark prints one line per variant with its throughput and a hash of the final state, so runs on
+// different machines can be compared for bit identity as well as speed.
+
+#include "core/Fixed.hpp"
+#include "core/Rollback.hpp"
+#include "core/Transform.hpp"
+#include "core/WorldBatch.hpp"
+#include "math/Math.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+uint64_t fnv1a(const void* data,size_t size,uint64_t hash=1469598103934665603ull){
+    const unsigned char* bytes=static_cast<const unsigned char*>(data);
+    for (size_t i=0;i<size;++i){
+        hash^=bytes[i];
+        hash*=1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+struct Box{
+    Vec2T<T> position;
+    Vec2T<T> velocity;
+    T rotation{0};
+    T angularVelocity{0};
+};
+
+template <typename T>
+uint64_t boxKernel(size_t count,int steps,double& seconds){
+
+    // A cut down step: gravity, integration, world-space transform of a box, AABB floor test with a bounce
+    // and a normalised drag. It touches every scalar operation the solver leans on ( mul/add, sqrt, sin/cos ).
+
+    const T dt(1.0f/60.0f);
+    const T gravity(-9.81f);
+    const T restitution(0.5f);
+    const T drag(0.01f);
+    const T half(0.5f);
+    const Vec2T<T> corners[4]={
+        Vec2T<T>(-half,-half),Vec2T<T>(half,-half),Vec2T<T>(half,half),Vec2T<T>(-half,half)
+    };
+
+    std::vector<Box<T>> boxes(count);
+    for (size_t i=0;i<count;++i){
+        Box<T>& b=boxes[i];
+        b.position=Vec2T<T>(T(static_cast<int>(i%100)),T(static_cast<int>(10+i%37)));
+        b.velocity=Vec2T<T>(T(static_cast<int>(i%7)-3),T(0));
+        b.angularVelocity=T(static_cast<float>(i%5)*0.25f);
+    }
+
+    const auto start=std::chrono::steady_clock::now();
+    for (int s=0;s<steps;++s){
+        for (Box<T>& b : boxes){
+            b.velocity.y+=gravity*dt;
+            b.velocity-=b.velocity.normalise()*drag;
+            b.position+=b.velocity*dt;
+            b.rotation+=b.angularVelocity*dt;
+
+            TransformT<T> transform(b.position,b.rotation);
+            T lowest=transform.applyTransform(corners[0]).y;
+            for (int c=1;c<4;++c){
+                const T y=transform.applyTransform(corners[c]).y;
+                if (y<lowest) lowest=y;
+            }
+            if (lowest<T(0)){
+                b.position.y-=lowest;
+                if (b.velocity.y<T(0)) b.velocity.y=-b.velocity.y*restitution;
+            }
+        }
+    }
+    seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    uint64_t hash=1469598103934665603ull;
+    for (const Box<T>& b : boxes) hash=fnv1a(&b,sizeof(b),hash);
+    return hash;
+
+}
+
+int benchScalar(size_t bodies,int steps){
+
+    double floatSeconds=0.0, doubleSeconds=0.0, fixedSeconds=0.0;
+    const uint64_t floatHash=boxKernel<float>(bodies,steps,floatSeconds);
+    const uint64_t doubleHash=boxKernel<double>(bodies,steps,doubleSeconds);
+    const uint64_t fixedHash=boxKernel<Fixed>(bodies,steps,fixedSeconds);
+
+    const double work=static_cast<double>(bodies)*steps;
+    std::printf("%-8s %12s %10s  %s\n","scalar","Mbody-steps/s","relative","state hash");
+    std::printf("%-8s %12.2f %10.2f  %016llx\n","float",work/floatSeconds/1e6,1.0,static_cast<unsigned long long>(floatHash));
+    std::printf("%-8s %12.2f %10.2f  %016llx\n","double",work/doubleSeconds/1e6,floatSeconds/doubleSeconds,static_cast<unsigned long long>(doubleHash));
+    std::printf("%-8s %12.2f %10.2f  %016llx\n","Q16.16",work/fixedSeconds/1e6,floatSeconds/fixedSeconds,static_cast<unsigned long long>(fixedHash));
+    return 0;
+
+}
+
+void fillPile(World& world,size_t index){
+
+    // A floor and a pile of 4 to 40 boxes, so tasks differ by an order of magnitude and stealing has work to do.
+
+    static const Vec2 floor[4]={Vec2(-20.0f,-0.5f),Vec2(20.0f,-0.5f),Vec2(20.0f,0.5f),Vec2(-20.0f,0.5f)};
+    static const Vec2 box[4]={Vec2(-0.5f,-0.5f),Vec2(0.5f,-0.5f),Vec2(0.5f,0.5f),Vec2(-0.5f,0.5f)};
+
+    std::vector<BodyDef> defs(1);
+    defs[0].vertices=floor;
+    defs[0].vertexCount=4;
+    defs[0].isStatic=true;
+    defs[0].mass=1.0f;
+
+    const size_t boxes=4+(index*7919)%37;
+    for (size_t i=0;i<boxes;++i){
+        BodyDef def;
+        def.vertices=box;
+        def.vertexCount=4;
+        def.mass=1.0f;
+        def.position=Vec2(static_cast<Real>(i%6)*1.1f-3.0f,1.0f+static_cast<Real>(i/6)*1.1f);
+        defs.push_back(def);
+    }
+    world.createBodies(defs);
+
+}
+
+int benchBatch(size_t worlds,int steps){
+
+    std::printf("%-8s %8s %14s %10s %8s  %s\n","threads","worlds","kWorld-steps/s","speedup","steals","state hash");
+    const size_t pool=std::max<size_t>(1,std::thread::hardware_concurrency());
+    double baseline=0.0;
+    for (size_t threads : {size_t(1),pool}){
+        WorldBatch batch(worlds,threads);
+        batch.parallelFor([](size_t index,World& world){ fillPile(world,index); });
+
+        const auto start=std::chrono::steady_clock::now();
+        batch.step(1.0f/60.0f,steps);
+        const double seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+        uint64_t hash=1469598103934665603ull;
+        for (size_t i=0;i<batch.size();++i){
+            const uint64_t h=batch.world(i).stateHash();
+            hash=fnv1a(&h,sizeof(h),hash);
+        }
+        const double rate=static_cast<double>(worlds)*steps/seconds;
+        if (threads==1) baseline=rate;
+        std::printf("%-8zu %8zu %14.2f %10.2f %8llu  %016llx\n",batch.threadCount(),worlds,rate/1e3,rate/baseline,
+                    static_cast<unsigned long long>(batch.steals()),static_cast<unsigned long long>(hash));
+        if (pool==1) break;
+    }
+    return 0;
+
+}
+
+void fillField(World& world,size_t bodies){
+
+    static const Vec2 box[4]={Vec2(-0.5f,-0.5f),Vec2(0.5f,-0.5f),Vec2(0.5f,0.5f),Vec2(-0.5f,0.5f)};
+    const size_t columns=100;
+    const Real width=static_cast<Real>(columns)*1.5f;
+    const Vec2 floor[4]={Vec2(-width,-0.5f),Vec2(width,-0.5f),Vec2(width,0.5f),Vec2(-width,0.5f)};
+
+    std::vector<BodyDef> defs(1);
+    defs[0].vertices=floor;
+    defs[0].vertexCount=4;
+    defs[0].isStatic=true;
+    defs[0].mass=1.0f;
+    for (size_t i=1;i<bodies;++i){
+        BodyDef def;
+        def.vertices=box;
+        def.vertexCount=4;
+        def.mass=1.0f;
+        def.position=Vec2(static_cast<Real>(i%columns)*1.5f-width*0.5f,1.0f+static_cast<Real>(i/columns)*1.2f);
+        defs.push_back(def);
+    }
+    world.createBodies(defs);
+
+}
+
+int benchFork(size_t bodies,int forks){
+
+    World source;
+    fillField(source,bodies);
+    source.step(1.0f/60.0f);
+
+    World fork;
+    auto start=std::chrono::steady_clock::now();
+    source.forkInto(fork);
+    const double first=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    // The source keeps simulating between forks, as a planner would
+    double total=0.0;
+    for (int i=0;i<forks;++i){
+        source.step(1.0f/60.0f);
+        start=std::chrono::steady_clock::now();
+        source.forkInto(fork);
+        total+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    }
+
+    World copy;
+    start=std::chrono::steady_clock::now();
+    copy=source;
+    const double assign=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    std::printf("%-14s %8s %12s  %s\n","fork","bodies","us","state hash");
+    std::printf("%-14s %8zu %12.1f  %016llx\n","assign",bodies,assign*1e6,static_cast<unsigned long long>(copy.stateHash()));
+    std::printf("%-14s %8zu %12.1f\n","first",bodies,first*1e6);
+    std::printf("%-14s %8zu %12.1f  %016llx\n","repeat (mean)",bodies,total/std::max(forks,1)*1e6,static_cast<unsigned long long>(fork.stateHash()));
+    return source.stateHash()==fork.stateHash() ? 0 : 1;
+
+}
+
+int benchRollback(size_t bodies,int frames){
+
+    // Every frame is saved, then rolled back 8 frames and resimulated, as when a late input arrives each frame.
+    // A reference World steps the same frames straight through, the two must end bit identical.
+
+    constexpr uint32_t kRewind=8;
+    const Real dt=1.0f/60.0f;
+    World world, reference;
+    fillField(world,bodies);
+    fillField(reference,bodies);
+
+    RollbackBuffer ring(2*kRewind,bodies,8*bodies);
+    double save=0.0, restore=0.0, resimulate=0.0;
+    uint32_t frame=0;
+    ring.save(world,frame);
+
+    using Clock=std::chrono::steady_clock;
+    auto seconds=[](Clock::time_point start){ return std::chrono::duration<double>(Clock::now()-start).count(); };
+    for (int f=0;f<frames;++f){
+        world.step(dt);
+        reference.step(dt);
+        ++frame;
+        auto start=Clock::now();
+        if (!ring.save(world,frame)) { std::fprintf(stderr,"ring too small\n"); return 1; }
+        save+=seconds(start);
+
+        if (frame<kRewind) continue;
+        start=Clock::now();
+        if (!ring.restore(world,frame-kRewind)) { std::fprintf(stderr,"restore failed\n"); return 1; }
+        restore+=seconds(start);
+
+        start=Clock::now();
+        for (uint32_t r=frame-kRewind+1;r<=frame;++r){
+            world.step(dt);
+            ring.save(world,r);
+        }
+        resimulate+=seconds(start);
+    }
+
+    const double n=static_cast<double>(std::max(frames,1));
+    std::printf("%-12s %8s %12s\n","rollback","bodies","us/frame");
+    std::printf("%-12s %8zu %12.1f\n","save",bodies,save/n*1e6);
+    std::printf("%-12s %8zu %12.1f\n","restore",bodies,restore/n*1e6);
+    std::printf("%-12s %8zu %12.1f\n","resim 8",bodies,resimulate/n*1e6);
+    std::printf("frame bytes %zu, bit identical to straight stepping: %s\n",ring.frameBytes(),
+                world.stateHash()==reference.stateHash() ? "yes" : "NO");
+    return world.stateHash()==reference.stateHash() ? 0 : 1;
+
+}
+
+int benchWorld(size_t bodies,int steps){
+
+    // The whole engine rather than a kernel: broad-phase, SAT, solver and integration over piles that keep
+    // colliding while they settle. The scene is built from the same literals in either precision.
+
+    World world;
+    fillField(world,bodies);
+    const Real dt=1.0f/60.0f;
+
+    const auto start=std::chrono::steady_clock::now();
+    for (int s=0;s<steps;++s) world.step(dt);
+    const double seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    const double work=static_cast<double>(world.getBodies().size())*steps;
+    std::printf("%-8s %8s %12s %10s  %s\n","world","bodies","Mbody-steps/s","ms/step","state hash");
+    std::printf("%-8s %8zu %12.3f %10.3f  %016llx\n",sizeof(Real)==sizeof(double) ? "double" : "float",world.getBodies().size(),
+                work/seconds/1e6,seconds/std::max(steps,1)*1e3,static_cast<unsigned long long>(world.stateHash()));
+    return 0;
+
+}
+
+} // namespace
+
+int main(int argc,char** argv){
+
+    if (argc<2){
+        std::fprintf(stderr,"Usage: PhysBench scalar [bodies] [steps]\n       PhysBench batch [worlds] [steps]\n       PhysBench fork [bodies] [forks]\n       PhysBench rollback [bodies] [frames]\n       PhysBench world [bodies] [steps]\n");
+        return 2;
+    }
+
+    if (std::strcmp(argv[1],"scalar")==0){
+        const size_t bodies=argc>2 ? std::strtoull(argv[2],nullptr,10) : 10000;
+        const int steps=argc>3 ? std::atoi(argv[3]) : 600;
+        return benchScalar(bodies,steps);
+    }
+
+    if (std::strcmp(argv[1],"batch")==0){
+        const size_t worlds=argc>2 ? std::strtoull(argv[2],nullptr,10) : 2000;
+        const int steps=argc>3 ? std::atoi(argv[3]) : 120;
+        return benchBatch(worlds,steps);
+    }
+
+    if (std::strcmp(argv[1],"fork")==0){
+        const size_t bodies=argc>2 ? std::strtoull(argv[2],nullptr,10) : 5000;
+        const int forks=argc>3 ? std::atoi(argv[3]) : 100;
+        return benchFork(bodies,forks);
+    }
+
+    if (std::strcmp(argv[1],"rollback")==0){
+        const size_t bodies=argc>2 ? std::strtoull(argv[2],nullptr,10) : 500;
+        const int frames=argc>3 ? std::atoi(argv[3]) : 120;
+        return benchRollback(bodies,frames);
+    }
+
+    if (std::strcmp(argv[1],"world")==0){
+        const size_t bodies=argc>2 ? std::strtoull(argv[2],nullptr,10) : 2000;
+        const int steps=argc>3 ? std::atoi(argv[3]) : 300;
+        return benchWorld(bodies,steps);
+    }
+
+    std::fprintf(stderr,"Unknown benchmark %s\n",argv[1]);
+    return 2;
+
+}
@@ -0,0 +1,153 @@
+// replay_verify.cpp
+// Headless tool that checks a simulation replays bit-identically.
+
+// Usage:
+//   ReplayVerify record <snapshot> <steps> <trace>   Simulates from snapshot, writes per-step state hashes to trace
+//   ReplayVerify verify <snapshot> <steps> <trace>   Simulates again and compares against trace
+//   ReplayVerify self   <snapshot> <steps>           Simulates twice in-process and compares
+//   ReplayVerify scene  <scene> <snapshot>           Loads a text or binary scene ( io/Scene.hpp ) and saves it as a snapshot
+// Exit code is 0 when the runs match, 1 on divergence and 2 on bad input.
+// Steps use a fixed dt of 1/120s, matching the demo viewer.
+
+#include "core/World.hpp"
+#include "io/Scene.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr float kFixedDt=1.0f/120.0f;
+constexpr uint32_t kTraceMagic=0x43525454; // "TTRC"
+
+bool simulate(const std::string& snapshotPath,uint64_t steps,std::vector<uint64_t>& hashes){
+
+    // Loads the snapshot and records the state hash after every step.
+
+    World world;
+    if (!world.loadSnapshot(snapshotPath)){
+        std::fprintf(stderr,"Failed to load snapshot %s\n",snapshotPath.c_str());
+        return false;
+    }
+    world.setDeterministic(true);
+
+    hashes.clear();
+    hashes.reserve(steps+1);
+    hashes.push_back(world.stateHash()); // Step 0 is the loaded state itself
+    for (uint64_t i=0;i<steps;++i){
+        world.step(kFixedDt);
+        hashes.push_back(world.lastStateHash());
+    }
+    return true;
+
+}
+
+bool writeTrace(const std::string& path,const std::vector<uint64_t>& hashes){
+    std::FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file) return false;
+    uint64_t count=hashes.size();
+    bool ok=std::fwrite(&kTraceMagic,sizeof(kTraceMagic),1,file)==1 &&
+            std::fwrite(&count,sizeof(count),1,file)==1 &&
+            std::fwrite(hashes.data(),sizeof(uint64_t),hashes.size(),file)==hashes.size();
+    return (std::fclose(file)==0) && ok;
+}
+
+bool readTrace(const std::string& path,std::vector<uint64_t>& hashes){
+    std::FILE* file=std::fopen(path.c_str(),"rb");
+    if (!file) return false;
+    uint32_t magic=0;
+    uint64_t count=0;
+    bool ok=std::fread(&magic,sizeof(magic),1,file)==1 && magic==kTraceMagic &&
+            std::fread(&count,sizeof(count),1,file)==1;
+    if (ok){
+        hashes.resize(count);
+        ok=std::fread(hashes.data(),sizeof(uint64_t),count,file)==count;
+    }
+    std::fclose(file);
+    return ok;
+}
+
+int compare(const std::vector<uint64_t>& expected,const std::vector<uint64_t>& actual){
+
+    // Reports the first divergent step, which is where to start bisecting.
+
+    size_t n=std::min(expected.size(),actual.size());
+    for (size_t i=0;i<n;++i){
+        if (expected[i]!=actual[i]){
+            std::printf("DIVERGED at step %zu: expected %016llx, got %016llx\n",i,
+                (unsigned long long)expected[i],(unsigned long long)actual[i]);
+            return 1;
+        }
+    }
+    if (expected.size()!=actual.size()){
+        std::printf("MISMATCH: trace has %zu steps, run has %zu\n",expected.size(),actual.size());
+        return 1;
+    }
+    std::printf("OK: %zu steps match, final hash %016llx\n",n,(unsigned long long)(n ? actual[n-1] : 0));
+    return 0;
+
+}
+
+} // namespace
+
+int main(int argc,char** argv){
+
+    if (argc<4){
+        std::fprintf(stderr,"usage: %s record|verify|self <snapshot> <steps> [trace]\n"
+                            "       %s scene <scene> <snapshot>\n",argv[0],argv[0]);
+        return 2;
+    }
+
+    std::string mode=argv[1];
+    if (mode=="scene"){
+        World world;
+        std::string error;
+        if (!scene::loadScene(argv[2],world,&error)){
+            std::fprintf(stderr,"Failed to load scene %s: %s\n",argv[2],error.c_str());
+            return 2;
+        }
+        if (!world.saveSnapshot(argv[3])){
+            std::fprintf(stderr,"Failed to write snapshot %s\n",argv[3]);
+            return 2;
+        }
+        std::printf("Saved %zu bodies to %s\n",world.getBodies().size(),argv[3]);
+        return 0;
+    }
+
+    std::string snapshotPath=argv[2];
+    uint64_t steps=std::strtoull(argv[3],nullptr,10);
+
+    std::vector<uint64_t> run;
+    if (!simulate(snapshotPath,steps,run)) return 2;
+
+    if (mode=="record" && argc>=5){
+        if (!writeTrace(argv[4],run)){
+            std::fprintf(stderr,"Failed to write trace %s\n",argv[4]);
+            return 2;
+        }
+        std::printf("Recorded %zu step hashes\n",run.size());
+        return 0;
+    }
+
+    if (mode=="verify" && argc>=5){
+        std::vector<uint64_t> expected;
+        if (!readTrace(argv[4],expected)){
+            std::fprintf(stderr,"Failed to read trace %s\n",argv[4]);
+            return 2;
+        }
+        return compare(expected,run);
+    }
+
+    if (mode=="self"){
+        std::vector<uint64_t> second;
+        if (!simulate(snapshotPath,steps,second)) return 2;
+        return compare(run,second);
+    }
+
+    std::fprintf(stderr,"Unknown mode %s\n",mode.c_str());
+    return 2;
+
+}
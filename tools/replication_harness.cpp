@@ -0,0 +1,230 @@
+// replication_harness.cpp
+// Headless driver for io/Replication.hpp.
+
+// Usage:
+//   ReplicationHarness loopback [clients] [bodies] [steps]   Server and clients in one process over 127.0.0.1
+//   ReplicationHarness serve [port] [bodies] [steps] [bind]  Simulates and serves at 60Hz, on loopback unless
+//                                                            bind names another interface ( 0.0.0.0 for all )
+//   ReplicationHarness client <host> <port> [seconds]        Headless client, prints what it receives once a second
+// loopback prints bandwidth per client and step, server time per client and broadcast, the mean view size and
+// the largest position error of any replicated body against the simulation. Exit code is 0 when every client
+// followed the server, 1 otherwise and 2 on bad input.
+
+#include "io/Replication.hpp"
+#include "math/Math.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr float kDt=1.0f/60.0f;
+
+void fillArena(World& world,size_t bodies){
+
+    // Boxes dropped in staggered rows onto a wide floor, so the scene mixes bodies at rest with falling and
+    // tumbling ones.
+
+    static const Vec2 box[4]={Vec2(-0.5f,-0.5f),Vec2(0.5f,-0.5f),Vec2(0.5f,0.5f),Vec2(-0.5f,0.5f)};
+    const size_t columns=200;
+    const Real width=static_cast<Real>(columns)*1.5f;
+    const Vec2 floor[4]={Vec2(-width,-0.5f),Vec2(width,-0.5f),Vec2(width,0.5f),Vec2(-width,0.5f)};
+
+    std::vector<BodyDef> defs(1);
+    defs[0].vertices=floor;
+    defs[0].vertexCount=4;
+    defs[0].isStatic=true;
+    defs[0].mass=1.0f;
+    for (size_t i=1;i<bodies;++i){
+        BodyDef def;
+        def.vertices=box;
+        def.vertexCount=4;
+        def.mass=1.0f;
+        def.restitution=0.3f;
+        def.position=Vec2(static_cast<Real>(i%columns)*1.5f-width*0.5f,1.0f+static_cast<Real>(i/columns)*4.0f);
+        def.angularVelocity=static_cast<Real>(static_cast<int>(i%7)-3)*0.5f;
+        defs.push_back(def);
+    }
+    world.createBodies(defs);
+
+}
+
+Vec2 observerAt(size_t client,size_t clients,int step){
+    // Clients spread along the arena, each drifting back and forth
+    const Real span=250.0f;
+    const Real base=(static_cast<Real>(client)+0.5f)/static_cast<Real>(clients)*span-span*0.5f;
+    return Vec2(base+static_cast<Real>(std::sin(step*0.01+client))*10.0f,5.0f);
+}
+
+int runLoopback(size_t clientCount,size_t bodies,int steps){
+
+    World world;
+    fillArena(world,bodies);
+
+    ReplicationServer server;
+    if (!server.open(0)){
+        std::fprintf(stderr,"Failed to open the server socket\n");
+        return 2;
+    }
+    std::vector<std::unique_ptr<ReplicationClient>> clients;
+    for (size_t i=0;i<clientCount;++i){
+        clients.push_back(std::make_unique<ReplicationClient>());
+        clients.back()->setObserver(observerAt(i,clientCount,0));
+        if (!clients.back()->connect("127.0.0.1",server.port())){
+            std::fprintf(stderr,"Failed to open client socket %zu\n",i);
+            return 2;
+        }
+    }
+
+    using Clock=std::chrono::steady_clock;
+    double serverSeconds=0.0;
+    double maxError=0.0;
+    size_t current=0; // Client views that matched the latest broadcast
+    std::vector<std::pair<uint32_t,Vec2>> truth; // ( id, position ), ascending by id
+
+    for (int s=1;s<=steps;++s){
+        world.step(kDt);
+
+        const auto start=Clock::now();
+        server.poll();
+        server.broadcast(world);
+        serverSeconds+=std::chrono::duration<double>(Clock::now()-start).count();
+
+        truth.clear();
+        for (const RigidBody& body : world.getBodies()) truth.push_back({body.id,body.position});
+        std::sort(truth.begin(),truth.end(),[](const auto& a,const auto& b){ return a.first<b.first; });
+
+        for (size_t i=0;i<clients.size();++i){
+            ReplicationClient& client=*clients[i];
+            client.setObserver(observerAt(i,clientCount,s));
+            client.poll();
+            if (s<2) continue; // Clients answer the server's challenge during step 1 and are registered in step 2
+            if (client.sequence()!=static_cast<uint32_t>(s)) continue;
+            current++;
+            for (const ReplicatedBody& body : client.bodies()){
+                auto it=std::lower_bound(truth.begin(),truth.end(),body.id,[](const auto& t,uint32_t id){ return t.first<id; });
+                if (it==truth.end() || it->first!=body.id) return 1; // Replicated a body the World does not have
+                maxError=std::max(maxError,static_cast<double>(vecMath::distance(it->second,body.position)));
+            }
+        }
+    }
+
+    const ReplicationStats& stats=server.stats();
+    const double views=static_cast<double>(std::max<uint64_t>(stats.packetsSent,1));
+    const double expected=static_cast<double>(clientCount)*std::max(steps-1,1);
+    uint64_t dropped=0;
+    for (const auto& client : clients) dropped+=client->dropped();
+
+    std::printf("%-22s %zu\n","clients",stats.clients);
+    std::printf("%-22s %zu\n","bodies",world.getBodies().size());
+    std::printf("%-22s %.1f\n","bytes/client/step",static_cast<double>(stats.bytesSent)/views);
+    std::printf("%-22s %.1f\n","bodies/view",static_cast<double>(stats.bodiesSent)/views);
+    std::printf("%-22s %.1f%%\n","changed bodies",100.0*static_cast<double>(stats.changedBodies)/std::max<double>(static_cast<double>(stats.bodiesSent),1.0));
+    std::printf("%-22s %llu\n","absolute views",static_cast<unsigned long long>(stats.absoluteViews));
+    std::printf("%-22s %llu\n","truncated views",static_cast<unsigned long long>(stats.truncatedViews));
+    std::printf("%-22s %llu\n","challenges",static_cast<unsigned long long>(stats.challenges));
+    std::printf("%-22s %llu\n","rejected clients",static_cast<unsigned long long>(stats.rejectedClients));
+    std::printf("%-22s %.2f\n","server us/client",serverSeconds/views*1e6);
+    std::printf("%-22s %.1f%%\n","views current",100.0*static_cast<double>(current)/expected);
+    std::printf("%-22s %.5f\n","max position error",maxError);
+    std::printf("%-22s %llu\n","client drops",static_cast<unsigned long long>(dropped));
+
+    // Views are quantized to positionPrecision, so the error is bounded by half a step per axis
+    const bool ok=current==static_cast<size_t>(expected) && maxError<=ReplicationConfig{}.positionPrecision;
+    return ok ? 0 : 1;
+
+}
+
+int runServe(uint16_t port,size_t bodies,int steps,const char* bind){
+
+    World world;
+    fillArena(world,bodies);
+    ReplicationServer server;
+    if (!server.open(port,bind)){
+        std::fprintf(stderr,"Failed to open %s:%u\n",bind,static_cast<unsigned>(port));
+        return 2;
+    }
+    std::printf("Serving %zu bodies on %s:%u\n",world.getBodies().size(),bind,static_cast<unsigned>(server.port()));
+
+    auto next=std::chrono::steady_clock::now();
+    for (int s=1;steps<=0 || s<=steps;++s){
+        world.step(kDt);
+        server.poll();
+        server.broadcast(world);
+        if (s%60==0){
+            const ReplicationStats& stats=server.stats();
+            std::printf("step %d clients %zu sent %llu bytes\n",s,stats.clients,static_cast<unsigned long long>(stats.bytesSent));
+            std::fflush(stdout);
+        }
+        next+=std::chrono::microseconds(static_cast<int64_t>(kDt*1e6f));
+        std::this_thread::sleep_until(next);
+    }
+    return 0;
+
+}
+
+int runClient(const char* host,uint16_t port,int seconds){
+
+    ReplicationClient client;
+    if (!client.connect(host,port)){
+        std::fprintf(stderr,"Failed to reach %s:%u\n",host,static_cast<unsigned>(port));
+        return 2;
+    }
+
+    const auto start=std::chrono::steady_clock::now();
+    for (int elapsed=0;seconds<=0 || elapsed<seconds;){
+        client.poll();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        const int now=static_cast<int>(std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count());
+        if (now==elapsed) continue;
+        elapsed=now;
+        std::printf("sequence %u bodies %zu received %llu bytes dropped %llu\n",client.sequence(),client.bodies().size(),
+                    static_cast<unsigned long long>(client.bytesReceived()),static_cast<unsigned long long>(client.dropped()));
+        std::fflush(stdout);
+    }
+    return client.sequence()>0 ? 0 : 1;
+
+}
+
+} // namespace
+
+int main(int argc,char** argv){
+
+    if (argc<2){
+        std::fprintf(stderr,"Usage: ReplicationHarness loopback [clients] [bodies] [steps]\n"
+                            "       ReplicationHarness serve [port] [bodies] [steps] [bind]\n"
+                            "       ReplicationHarness client <host> <port> [seconds]\n");
+        return 2;
+    }
+
+    if (std::strcmp(argv[1],"loopback")==0){
+        const size_t clients=argc>2 ? std::strtoull(argv[2],nullptr,10) : 200;
+        const size_t bodies=argc>3 ? std::strtoull(argv[3],nullptr,10) : 4000;
+        const int steps=argc>4 ? std::atoi(argv[4]) : 300;
+        return runLoopback(clients,bodies,steps);
+    }
+
+    if (std::strcmp(argv[1],"serve")==0){
+        const uint16_t port=static_cast<uint16_t>(argc>2 ? std::atoi(argv[2]) : 27960);
+        const size_t bodies=argc>3 ? std::strtoull(argv[3],nullptr,10) : 4000;
+        const int steps=argc>4 ? std::atoi(argv[4]) : 0;
+        const char* bind=argc>5 ? argv[5] : "127.0.0.1";
+        return runServe(port,bodies,steps,bind);
+    }
+
+    if (std::strcmp(argv[1],"client")==0 && argc>3){
+        const uint16_t port=static_cast<uint16_t>(std::atoi(argv[3]));
+        const int seconds=argc>4 ? std::atoi(argv[4]) : 0;
+        return runClient(argv[2],port,seconds);
+    }
+
+    std::fprintf(stderr,"Unknown mode %s\n",argv[1]);
+    return 2;
+
+}